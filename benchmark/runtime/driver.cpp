@@ -0,0 +1,150 @@
+// The driver of the runtime benchmark, runs the synthetic test programs and prints the overheads of minitest on them.
+// Usage: minitest_bench_driver <repetitions> <test cases> <program> [<test cases> <program>]...
+// The first program is the baseline with no test cases, the process startup of the others is measured against it.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif // _WIN32
+
+namespace
+{
+struct program
+{
+    std::size_t test_cases;
+    std::string path;
+    // the measurements in the order of the rows of the report
+    std::vector<std::pair<std::string, double>> results;
+
+    const double *find(const std::string &row) const
+    {
+        auto result = std::find_if(results.begin(), results.end(), [&](auto &result) { return result.first == row; });
+        return result == results.end() ? nullptr : &result->second;
+    }
+};
+
+int repetitions = 11;
+
+std::string command_line(const std::string &path, const std::string &args)
+{
+#ifdef _WIN32
+    // cmd.exe strips the outer quotes of the command line
+    return std::format("\"\"{}\" {} >NUL 2>&1\"", path, args);
+#else
+    return std::format("\"{}\" {} >/dev/null 2>&1", path, args);
+#endif // _WIN32
+}
+
+double median(std::vector<double> samples)
+{
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+// the median of the wall time of the command in milliseconds, `prepare` is called before each run and isn't timed
+double time_command(const std::string &command, auto &&prepare)
+{
+    std::vector<double> samples;
+    for (int run = 0; run < repetitions; ++run)
+    {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        if (std::system(command.c_str()))
+        {
+            std::cerr << "minitest_bench: the command failed: " << command << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return median(samples);
+}
+
+double time_command(const std::string &command)
+{
+    return time_command(command, [] {});
+}
+
+// the `<name>\t<nanoseconds>` lines printed by the program with --bench-in-process
+void read_in_process_results(program &p)
+{
+    auto pipe = popen(std::format("\"{}\" --bench-in-process", p.path).c_str(), "r");
+    if (!pipe)
+    {
+        std::cerr << "minitest_bench: failed to run " << p.path << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    char line[256];
+    while (std::fgets(line, sizeof(line), pipe))
+    {
+        std::string_view text(line);
+        auto tab = text.find('\t');
+        if (tab == std::string_view::npos) { continue; }
+        p.results.emplace_back(std::format("{} (ns)", text.substr(0, tab)), std::strtod(line + tab + 1, nullptr));
+    }
+    pclose(pipe);
+}
+
+void measure_discovery(program &p)
+{
+    const std::string guid = "minitest_bench_B06065BA2B364445A11B6E98E779BBA1";
+    auto file = std::filesystem::absolute(std::format("CTestTestfile_{}.cmake", p.test_cases));
+    auto command = command_line(p.path, std::format("--minitest-pri-impl-discover-test-cases {} \"{}\"", guid,
+                                            file.string()));
+    p.results.emplace_back("discovery into an empty file (ms)", time_command(command, [&] { std::ofstream{file}; }));
+    // the file has the test cases discovered by the last run, as after a rebuild
+    p.results.emplace_back("rediscovery into the previous file (ms)", time_command(command));
+    p.results.emplace_back("size of the CTest file (KiB)", std::filesystem::file_size(file) / 1024.0);
+    std::filesystem::remove(file);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 4 || argc % 2)
+    {
+        std::cerr << "Usage: minitest_bench_driver <repetitions> <test cases> <program> [<test cases> <program>]..."
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    repetitions = std::max(1, std::atoi(argv[1]));
+    std::vector<program> programs;
+    for (int i = 2; i < argc; i += 2) { programs.push_back({std::strtoull(argv[i], nullptr, 10), argv[i + 1], {}}); }
+
+    const std::string startup = "process startup, not a test run (ms)";
+    for (auto &p : programs)
+    {
+        std::cerr << std::format("minitest_bench: measuring {} test cases", p.test_cases) << std::endl;
+        p.results.emplace_back(startup, time_command(command_line(p.path, "")));
+        if (p.test_cases == 0) { continue; }
+        p.results.emplace_back("registration per test case (ns)",
+            (*p.find(startup) - *programs.front().find(startup)) * 1e6 / p.test_cases);
+        measure_discovery(p);
+        read_in_process_results(p);
+    }
+
+    std::cout << std::format("minitest runtime benchmark, the medians of {} runs", repetitions) << std::endl;
+    std::cout << std::format("{:<44}", "");
+    for (auto &p : programs) { std::cout << std::format("{:>14}", std::format("{} cases", p.test_cases)); }
+    std::cout << std::endl;
+    // the last program has all the rows
+    for (auto &[row, _] : programs.back().results)
+    {
+        std::cout << std::format("{:<44}", row);
+        for (auto &p : programs)
+        {
+            auto result = p.find(row);
+            std::cout << (result ? std::format("{:>14.2f}", *result) : std::format("{:>14}", "-"));
+        }
+        std::cout << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+// The synthetic test program of the runtime benchmark. With --bench-in-process, it measures the overheads of minitest in
+// the process and prints them as `<name>\t<nanoseconds>` lines, otherwise it's an ordinary test program.
+#include <Atliac/minitest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+volatile int value = 1;
+
+// a stream buffer which discards the output
+struct null_buffer : std::streambuf
+{
+    null_buffer() { setp(buffer, std::end(buffer)); }
+    int overflow(int c) override
+    {
+        setp(buffer, std::end(buffer));
+        return c;
+    }
+    char buffer[256];
+};
+
+// the median of the time of one call of f in 11 runs, in nanoseconds
+double measure(int iterations, auto &&f)
+{
+    std::vector<double> samples;
+    for (int run = 0; run < 11; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) { f(); }
+        samples.push_back(
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations);
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+void measure_in_process(const char *program)
+{
+    const char *non_test_argv[] = {program, nullptr};
+    std::vector<std::pair<std::string_view, double>> results;
+    results.emplace_back("MINITEST_RUN_TESTS, not a test run",
+        measure(1000, [&] { (void)minitest::pri_impl::try_run_test(1, non_test_argv); }));
+    results.emplace_back("ASSERT_TRUE, passed", measure(1'000'000, [] { ASSERT_TRUE(value == 1, "value: ", value); }));
+    results.emplace_back("EXPECT_FALSE, passed", measure(1'000'000, [] { EXPECT_FALSE(value == 2, "value: ", value); }));
+    results.emplace_back("ASSERT_THROW, passed", measure(10'000, [] { ASSERT_THROW(throw int(value), int); }));
+    results.emplace_back("EXPECT_NO_THROW, passed", measure(1'000'000, [] { EXPECT_NO_THROW((void)value); }));
+
+    // the failure messages are formatted, then discarded
+    null_buffer discard;
+    auto cout_buff = std::cout.rdbuf(&discard);
+    results.emplace_back("EXPECT_TRUE, failed", measure(10'000, [] { EXPECT_TRUE(value == 2, "value: ", value); }));
+    results.emplace_back("EXPECT_NO_THROW, failed",
+        measure(10'000, [] { EXPECT_NO_THROW(throw std::out_of_range("out of range")); }));
+    std::cout.rdbuf(cout_buff);
+
+    for (auto &[name, nanoseconds] : results) { std::printf("%s\t%.1f\n", name.data(), nanoseconds); }
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && std::string_view(argv[1]) == "--bench-in-process")
+    {
+        measure_in_process(argv[0]);
+        return 0;
+    }
+    MINITEST_RUN_TESTS(argc, argv);
+    return 0;
+}
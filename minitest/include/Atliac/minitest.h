@@ -10,52 +10,65 @@
 // ==========================================================================
 
 #pragma once
-#include <cstring>
-#include <exception>
+#include <Atliac/minitest_core.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <format>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <string_view>
-#include <syncstream>
-#include <typeinfo>
-#if __has_include(<cxxabi.h>)
-#include <cxxabi.h>
-#endif
-
-#if defined(_WIN32) && (!defined(_MSVC_TRADITIONAL) || _MSVC_TRADITIONAL)
-#error The conforming preprocessor is required. Use '/Zc:preprocessor' compiler option to enable it.
-#endif // defined(_WIN32) &&(!defined(_MSVC_TRADITIONAL) || _MSVC_TRADITIONAL)
-
-#if defined(_WIN32) && defined(minitest_SHARED_LIB)
-#ifdef minitest_EXPORTS
-#define PRI_IMPL_MINITEST_EXPORT __declspec(dllexport)
-#else
-#define PRI_IMPL_MINITEST_EXPORT __declspec(dllimport)
-#endif // minitest_EXPORTS
+
+// the functions called by the coverage callbacks must not be instrumented themselves
+#if defined(__clang__)
+#define PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE __attribute__((no_sanitize("coverage")))
+#elif defined(__GNUC__)
+#define PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE __attribute__((no_sanitize_coverage))
 #else
-#define PRI_IMPL_MINITEST_EXPORT
-#endif // minitest_SHARED_LIB
+#define PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE
+#endif // defined(__clang__)
 
-#define PRI_IMPL_MINITEST_UNIQ_NAME1(name, id) name##id
-#define PRI_IMPL_MINITEST_UNIQ_NAME(name, id) PRI_IMPL_MINITEST_UNIQ_NAME1(name, id)
+namespace minitest
+{
+// How the child process of a death test ended, see MINITEST_ASSERT_EXIT.
+struct death_test_status
+{
+    // the child process exited with `exit_code`
+    bool exited = false;
+    int exit_code = 0;
+    // the child process was terminated by `signal`
+    bool signaled = false;
+    int signal = 0;
+    // the statement returned or threw an exception instead of terminating the child process
+    bool returned = false;
+    bool threw = false;
+    // the child process was killed after the death test timeout
+    bool timed_out = false;
+};
 
-#define PRI_IMPL_MINITEST_STRINGIFY1(x) #x
-#define PRI_IMPL_MINITEST_STRINGIFY(x) PRI_IMPL_MINITEST_STRINGIFY1(x)
+// A death test predicate, true if the child process exited with the code.
+struct exited_with_code
+{
+    int code;
 
-#define MINITEST_SUCCESS 0
-#define MINITEST_FAILURE 1
+    bool operator()(const death_test_status &status) const { return status.exited && status.exit_code == code; }
+};
 
-namespace minitest
+// A death test predicate, true if the child process was terminated by the signal.
+struct killed_by_signal
 {
-class minitest_assertion_failure : public std::exception
-{
-    using std::exception::exception;
+    int signal;
 
-  public:
-    const char *what() const noexcept override { return "minitest assertion failure"; }
+    bool operator()(const death_test_status &status) const { return status.signaled && status.signal == signal; }
 };
 
-PRI_IMPL_MINITEST_EXPORT bool silent_mode();
+// The child process of a death test is killed if it doesn't end in time, 60 seconds by default.
+PRI_IMPL_MINITEST_EXPORT void set_death_test_timeout(double seconds);
 
 namespace pri_impl
 {
@@ -64,321 +77,423 @@ const auto flag_pri_impl_discover_test_cases = "--minitest-pri-impl-discover-tes
 const auto flag_list_test_cases = "--minitest-list-test-cases";
 const auto flag_run_test_case = "--minitest-run-test-case";
 const auto flag_run_nth_test_case = "--minitest-run-nth-test-case";
-
-// exception class meant to be caught and ignored
-class minitest_do_nothing
+const auto flag_filter = "--minitest-filter";
+const auto flag_shuffle = "--minitest-shuffle";
+const auto flag_detect_order_deps = "--minitest-detect-order-deps";
+const auto flag_retries = "--minitest-retries";
+const auto flag_flaky_stats = "--minitest-flaky-stats";
+const auto flag_repeat = "--minitest-repeat";
+const auto flag_until_fail = "--minitest-until-fail";
+const auto flag_dump_probes = "--minitest-dump-probes";
+const auto flag_history = "--minitest-history";
+const auto flag_history_report = "--minitest-history-report";
+const auto flag_check_memory = "--minitest-check-memory";
+const auto flag_update_snapshots = "--minitest-update-snapshots";
+const auto flag_cpus = "--minitest-cpus";
+const auto flag_numa_node = "--minitest-numa-node";
+const auto flag_isolate = "--minitest-isolate";
+const auto flag_serve = "--minitest-serve";
+const auto flag_impact_index = "--minitest-impact-index";
+const auto flag_changed_files = "--minitest-changed-files";
+
+using death_test_statement_type = void (*)(void *context);
+
+// Run the statement in a child process, the stderr output of the child process is captured. Forks the process
+// without exec, death tests are not supported on Windows.
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT death_test_status run_death_test(
+    death_test_statement_type statement, void *context, std::string &stderr_output);
+
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT bool match_death_test_output(const std::string &stderr_output, const char *regex);
+
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT std::string describe_death_test(
+    const death_test_status &status, const std::string &stderr_output);
+
+// a statement dies if it terminates the process with a non-zero exit code or a signal
+inline bool died(const death_test_status &status)
 {
-};
+    return (status.exited && status.exit_code != 0) || status.signaled;
+}
 
-#ifdef _WIN32
-// thread-safe
-PRI_IMPL_MINITEST_EXPORT void win32_allocate_console();
-#endif // _WIN32
+// The demangled name of the type, cached after the first call. The view is valid until the program exits, or until the
+// next call on the thread if the cache is full.
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT std::string_view get_type_name(const std::type_info &type);
+
+std::string_view get_type_name(auto &&o) { return get_type_name(typeid(o)); }
 
-using test_case_function_type = void (*)();
+// Probes are sharded by thread, each shard takes whole cache lines, so threads recording the same probe don't
+// contend on a cache line.
+inline constexpr std::size_t probe_shard_count = 16;
+inline constexpr std::size_t probe_cache_line_size = 64;
 
-inline void print_message(std::ostream &) {}
+// thread-safe, assigns the shards round-robin
+PRI_IMPL_MINITEST_EXPORT std::size_t next_probe_shard();
 
-template <class M, class... Ms> void print_message(std::ostream &os, M &&m, Ms &&...ms)
+inline std::size_t probe_shard()
 {
-    os << std::forward<M>(m);
-    print_message(os, std::forward<Ms>(ms)...);
+    thread_local const std::size_t shard = next_probe_shard();
+    return shard;
 }
 
-PRI_IMPL_MINITEST_EXPORT void signal_expectation_failure();
+class counter_probe
+{
+  public:
+    void add(std::uint64_t n) { shards_[probe_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t value() const
+    {
+        std::uint64_t value = 0;
+        for (auto &shard : shards_) { value += shard.value.load(std::memory_order_relaxed); }
+        return value;
+    }
+
+    void reset()
+    {
+        for (auto &shard : shards_) { shard.value.store(0, std::memory_order_relaxed); }
+    }
+
+  private:
+    struct alignas(probe_cache_line_size) shard
+    {
+        std::atomic<std::uint64_t> value{0};
+    };
+    shard shards_[probe_shard_count];
+};
+
+// A log-linear histogram, the values below 16 have their own buckets, and the range of each power of two above is
+// split into 8 buckets, so a bucket is at most 1/8 of its lower bound wide.
+class histogram_probe
+{
+  public:
+    static constexpr std::size_t bucket_count = 16 + 60 * 8;
+
+    static constexpr std::size_t bucket_index(std::uint64_t value)
+    {
+        if (value < 16) { return static_cast<std::size_t>(value); }
+        auto exponent = static_cast<std::size_t>(std::bit_width(value) - 1);
+        return 16 + (exponent - 4) * 8 + static_cast<std::size_t>((value >> (exponent - 3)) & 7);
+    }
+
+    static constexpr std::uint64_t bucket_lower_bound(std::size_t index)
+    {
+        if (index < 16) { return index; }
+        auto exponent = (index - 16) / 8 + 4;
+        return (8 + (index - 16) % 8) << (exponent - 3);
+    }
+
+    void record(std::uint64_t value)
+    {
+        auto &shard = shards_[probe_shard()];
+        shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        auto max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // merges the shards, thread-safe but not a consistent snapshot while other threads record values
+    void merge(std::uint64_t (&buckets)[bucket_count], std::uint64_t &sum, std::uint64_t &max) const
+    {
+        std::fill(std::begin(buckets), std::end(buckets), 0);
+        sum = max = 0;
+        for (auto &shard : shards_)
+        {
+            for (std::size_t i = 0; i < bucket_count; ++i)
+            {
+                buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            sum += shard.sum.load(std::memory_order_relaxed);
+            max = std::max(max, shard.max.load(std::memory_order_relaxed));
+        }
+    }
+
+    void reset()
+    {
+        for (auto &shard : shards_)
+        {
+            for (auto &bucket : shard.buckets) { bucket.store(0, std::memory_order_relaxed); }
+            shard.sum.store(0, std::memory_order_relaxed);
+            shard.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    struct alignas(probe_cache_line_size) shard
+    {
+        std::atomic<std::uint64_t> buckets[bucket_count]{};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> max{0};
+    };
+    shard shards_[probe_shard_count];
+};
 
-class PRI_IMPL_MINITEST_EXPORT auto_reg_test_case
+// records the lifetime of the timer in nanoseconds
+class scoped_timer
 {
   public:
-    auto_reg_test_case(
-        const char *test_case_name, test_case_function_type test_case_func, const char *test_case_location);
+    explicit scoped_timer(histogram_probe &probe) : probe_(probe), start_(std::chrono::steady_clock::now()) {}
+    scoped_timer(const scoped_timer &) = delete;
+    scoped_timer &operator=(const scoped_timer &) = delete;
+
+    ~scoped_timer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        probe_.record(static_cast<std::uint64_t>(std::chrono::nanoseconds(elapsed).count()));
+    }
+
+  private:
+    histogram_probe &probe_;
+    std::chrono::steady_clock::time_point start_;
 };
 
-[[nodiscard]] PRI_IMPL_MINITEST_EXPORT int run_test(int argc, const char *const *argv);
-#ifdef _WIN32
-[[nodiscard]] PRI_IMPL_MINITEST_EXPORT int win32_run_test();
-#endif // _WIN32
+// thread-safe, registers the probe on first use, the probes live until the process exits
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT counter_probe &get_counter_probe(const char *name);
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT histogram_probe &get_histogram_probe(const char *name);
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT histogram_probe &get_timer_probe(const char *name);
 
-std::string get_type_name(auto &&o)
+// the bytes of a string, or of a contiguous range of trivially copyable values
+template <class T> std::string_view snapshot_bytes(const T &value)
 {
-#if __has_include(<cxxabi.h>)
-    int status;
-    auto demangled = abi::__cxa_demangle(typeid(o).name(), nullptr, nullptr, &status);
-    std::string type_name = demangled;
-    free(demangled);
-    if (status) { return std::format("failed to demangle type name: {}, status: {}", typeid(o).name(), status); }
-    return type_name;
-#else
-    return typeid(o).name();
-#endif
-}
-} // namespace pri_impl
-} // namespace minitest
-#ifdef _WIN32
-#define PRI_IMPL_WIN32_ALLOCATE_CONSOLE_IN_NON_SILENT_MODE()                            \
-    do {                                                                                \
-        if (!minitest::silent_mode()) { minitest::pri_impl::win32_allocate_console(); } \
-    } while (false)
-#else
-#define PRI_IMPL_WIN32_ALLOCATE_CONSOLE_IN_NON_SILENT_MODE() void(0)
-#endif // _WIN32
-
-#define PRI_IMPL_PRINT_MESSAGE(msg, ...)                                                                        \
-    {                                                                                                           \
-        PRI_IMPL_WIN32_ALLOCATE_CONSOLE_IN_NON_SILENT_MODE();                                                   \
-        std::osyncstream o(std::cout);                                                                          \
-        o << msg << std::endl;                                                                                  \
-        __VA_OPT__(o << "Custom message: "; minitest::pri_impl::print_message(o, __VA_ARGS__); o << std::endl;) \
-        std::string_view location = __FILE__ ":" PRI_IMPL_MINITEST_STRINGIFY(__LINE__);                         \
-        o << std::format("{}\n\n", location);                                                                   \
+    if constexpr (std::is_convertible_v<const T &, std::string_view>) { return value; }
+    else
+    {
+        static_assert(std::is_trivially_copyable_v<std::remove_cvref_t<decltype(*std::data(value))>>);
+        return {reinterpret_cast<const char *>(std::data(value)), std::size(value) * sizeof(*std::data(value))};
     }
+}
 
-#ifndef MINITEST_CONFIG_DISABLE
-#define MINITEST_RUN_TESTS(argc, argv)                          \
-    do {                                                        \
-        try                                                     \
-        {                                                       \
-            return minitest::pri_impl::run_test(argc, argv);    \
-        }                                                       \
-        catch (const minitest::pri_impl::minitest_do_nothing &) \
-        {                                                       \
-        }                                                       \
-    } while (false)
-#else
-#define MINITEST_RUN_TESTS(argc, argv) void(0)
-#endif // !MINITEST_CONFIG_DISABLE
+// Compares the content with the snapshot file `name`, relative to the `snapshots` directory next to the source file of
+// `location`. Returns the description of the difference, empty if they match. The file is written instead if the
+// snapshots are being updated.
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT std::string match_snapshot(
+    const char *location, const char *name, std::string_view content);
 
-#ifdef _WIN32
-#ifndef MINITEST_CONFIG_DISABLE
-#include <Windows.h>
-#define MINITEST_WIN32_RUN_TESTS()                              \
-    do {                                                        \
-        try                                                     \
-        {                                                       \
-            return minitest::pri_impl::win32_run_test();        \
-        }                                                       \
-        catch (const minitest::pri_impl::minitest_do_nothing &) \
-        {                                                       \
-        }                                                       \
-    } while (false)
-#else
-#define MINITEST_WIN32_RUN_TESTS() void(0)
-#endif // !MINITEST_CONFIG_DISABLE
-#endif // _WIN32
+// the global allocator installed by MINITEST_COUNT_ALLOCATIONS, thread-safe
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT void *counted_allocate(std::size_t size);
+PRI_IMPL_MINITEST_EXPORT void counted_deallocate(void *p) noexcept;
 
-#ifndef MINITEST_CONFIG_DISABLE
-#define MINITEST_TEST_CASE(test_case_name)                                                                      \
-    static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)();                                 \
-    static minitest::pri_impl::auto_reg_test_case PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_v_, __LINE__)( \
-        test_case_name, PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__),                           \
-        __FILE__ ":" PRI_IMPL_MINITEST_STRINGIFY(__LINE__));                                                    \
-    static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
-#else
-#define MINITEST_TEST_CASE(test_case_name) \
-    [[maybe_unused]] static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
-#endif // !MINITEST_CONFIG_DISABLE
+// called by the report hooks defined by MINITEST_RECORD_SANITIZER_REPORTS, the reports are ignored until test cases run
+PRI_IMPL_MINITEST_EXPORT void on_sanitizer_report(const char *sanitizer) noexcept;
 
-#ifndef MINITEST_CONFIG_DISABLE
-#define MINITEST_ASSERT_TRUE(expr, ...)                                                             \
-    do {                                                                                            \
-        if (expr) break;                                                                            \
-        PRI_IMPL_PRINT_MESSAGE(std::format("minitest ASSERT_TRUE({}) failed", #expr), __VA_ARGS__); \
-        throw minitest::minitest_assertion_failure{};                                               \
-    } while (false)
-#define MINITEST_ASSERT_FALSE(expr, ...)                                                             \
-    do {                                                                                             \
-        if (!(expr)) break;                                                                          \
-        PRI_IMPL_PRINT_MESSAGE(std::format("minitest ASSERT_FALSE({}) failed", #expr), __VA_ARGS__); \
-        throw minitest::minitest_assertion_failure{};                                                \
-    } while (false)
-#define MINITEST_SUCCEED(...)                                      \
-    do {                                                           \
-        PRI_IMPL_PRINT_MESSAGE("minitest SUCCEED()", __VA_ARGS__); \
-    } while (false)
-#define MINITEST_FAIL(...)                                      \
-    do {                                                        \
-        PRI_IMPL_PRINT_MESSAGE("minitest FAIL()", __VA_ARGS__); \
-        throw minitest::minitest_assertion_failure{};           \
-    } while (false)
-#define MINITEST_ASSERT_THROW(expr, exception_type, ...)                                                           \
-    do {                                                                                                           \
-        try                                                                                                        \
-        {                                                                                                          \
-            expr;                                                                                                  \
-            PRI_IMPL_PRINT_MESSAGE(                                                                                \
-                std::format("minitest ASSERT_THROW({}) failed: The expected exception `{}` was not thrown.",       \
-                    #expr ", " #exception_type, #exception_type),                                                  \
-                __VA_ARGS__);                                                                                      \
-            throw minitest::minitest_assertion_failure{};                                                          \
-        }                                                                                                          \
-        catch (const minitest::minitest_assertion_failure &)                                                       \
-        {                                                                                                          \
-            throw;                                                                                                 \
-        }                                                                                                          \
-        catch (const exception_type &)                                                                             \
-        {                                                                                                          \
-        }                                                                                                          \
-        catch (...)                                                                                                \
-        {                                                                                                          \
-            try                                                                                                    \
-            {                                                                                                      \
-                std::rethrow_exception(std::current_exception());                                                  \
-            }                                                                                                      \
-            catch (const std::exception &e)                                                                        \
-            {                                                                                                      \
-                PRI_IMPL_PRINT_MESSAGE(                                                                            \
-                    std::format(                                                                                   \
-                        "minitest ASSERT_THROW({}) failed: The exception '{}' was thrown, but not the expected "   \
-                        "exception `{}`.",                                                                         \
-                        #expr ", " #exception_type, minitest::pri_impl::get_type_name(e), #exception_type),        \
-                    __VA_ARGS__);                                                                                  \
-                throw minitest::minitest_assertion_failure{};                                                      \
-            }                                                                                                      \
-            catch (...)                                                                                            \
-            {                                                                                                      \
-                PRI_IMPL_PRINT_MESSAGE(                                                                            \
-                    std::format(                                                                                   \
-                        "minitest ASSERT_THROW({}) failed: An unknown exception was thrown, but not the expected " \
-                        "exception `{}`.",                                                                         \
-                        #expr ", " #exception_type, #exception_type),                                              \
-                    __VA_ARGS__);                                                                                  \
-                throw minitest::minitest_assertion_failure{};                                                      \
-            }                                                                                                      \
-        }                                                                                                          \
-    } while (false)
+// the coverage callbacks defined by MINITEST_RECORD_COVERAGE, the guards are disabled until a test case is recorded
+PRI_IMPL_MINITEST_EXPORT void coverage_guard_init(std::uint32_t *start, std::uint32_t *stop);
+// the PC is the return address of the callback of the first hit of a guard in the recorded test case
+PRI_IMPL_MINITEST_EXPORT void coverage_guard_hit(std::uintptr_t pc) noexcept;
+} // namespace pri_impl
 
-#define MINITEST_ASSERT_NO_THROW(expr, ...)                                                                           \
-    do {                                                                                                              \
-        try                                                                                                           \
-        {                                                                                                             \
-            expr;                                                                                                     \
-        }                                                                                                             \
-        catch (const std::exception &e)                                                                               \
-        {                                                                                                             \
-            PRI_IMPL_PRINT_MESSAGE(std::format("minitest ASSERT_NO_THROW({}) failed: The exception `{}` was thrown.", \
-                                       #expr, minitest::pri_impl::get_type_name(e)),                                  \
-                __VA_ARGS__);                                                                                         \
-            throw minitest::minitest_assertion_failure{};                                                             \
-        }                                                                                                             \
-        catch (...)                                                                                                   \
-        {                                                                                                             \
-            PRI_IMPL_PRINT_MESSAGE(                                                                                   \
-                std::format("minitest ASSERT_NO_THROW({}) failed: An unknown exception was thrown.", #expr),          \
-                __VA_ARGS__);                                                                                         \
-            throw minitest::minitest_assertion_failure{};                                                             \
-        }                                                                                                             \
-    } while (false)
+// Returns the value of the counter probe, 0 if the counter has never been incremented.
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT std::uint64_t counter_value(const char *name);
 
-#define MINITEST_EXPECT_TRUE(expr, ...)                                                             \
-    do {                                                                                            \
-        if (expr) break;                                                                            \
-        PRI_IMPL_PRINT_MESSAGE(std::format("minitest EXPECT_TRUE({}) failed", #expr), __VA_ARGS__); \
-        minitest::pri_impl::signal_expectation_failure();                                           \
-    } while (false)
+// A virtual monotonic clock satisfying the Clock requirements, for the code under test templated on the clock. The time
+// starts at the epoch and only moves with advance(), or when an event loop is idle with virtual timers pending.
+class PRI_IMPL_MINITEST_EXPORT clock
+{
+  public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<clock>;
+    static constexpr bool is_steady = true;
+
+    // thread-safe
+    [[nodiscard]] static time_point now() noexcept;
+    // thread-safe, negative durations are ignored
+    static void advance(duration d) noexcept;
+};
 
-#define MINITEST_EXPECT_FALSE(expr, ...)                                                             \
-    do {                                                                                             \
-        if (!(expr)) break;                                                                          \
-        PRI_IMPL_PRINT_MESSAGE(std::format("minitest EXPECT_FALSE({}) failed", #expr), __VA_ARGS__); \
-        minitest::pri_impl::signal_expectation_failure();                                            \
-    } while (false)
+// Resets all probes to zero, e.g. after a warm-up.
+PRI_IMPL_MINITEST_EXPORT void reset_probes();
 
-#define MINITEST_EXPECT_THROW(expr, exception_type, ...)                                                           \
-    do {                                                                                                           \
-        try                                                                                                        \
-        {                                                                                                          \
-            expr;                                                                                                  \
-            PRI_IMPL_PRINT_MESSAGE(                                                                                \
-                std::format("minitest EXPECT_THROW({}) failed: The expected exception `{}` was not thrown.",       \
-                    #expr ", " #exception_type, #exception_type),                                                  \
-                __VA_ARGS__);                                                                                      \
-            minitest::pri_impl::signal_expectation_failure();                                                      \
-        }                                                                                                          \
-        catch (const exception_type &)                                                                             \
-        {                                                                                                          \
-        }                                                                                                          \
-        catch (...)                                                                                                \
-        {                                                                                                          \
-            try                                                                                                    \
-            {                                                                                                      \
-                std::rethrow_exception(std::current_exception());                                                  \
-            }                                                                                                      \
-            catch (const std::exception &e)                                                                        \
-            {                                                                                                      \
-                PRI_IMPL_PRINT_MESSAGE(                                                                            \
-                    std::format(                                                                                   \
-                        "minitest EXPECT_THROW({}) failed: The exception '{}' was thrown, but not the expected "   \
-                        "exception `{}`.",                                                                         \
-                        #expr ", " #exception_type, minitest::pri_impl::get_type_name(e), #exception_type),        \
-                    __VA_ARGS__);                                                                                  \
-                minitest::pri_impl::signal_expectation_failure();                                                  \
-            }                                                                                                      \
-            catch (...)                                                                                            \
-            {                                                                                                      \
-                PRI_IMPL_PRINT_MESSAGE(                                                                            \
-                    std::format(                                                                                   \
-                        "minitest EXPECT_THROW({}) failed: An unknown exception was thrown, but not the expected " \
-                        "exception `{}`.",                                                                         \
-                        #expr ", " #exception_type, #exception_type),                                              \
-                    __VA_ARGS__);                                                                                  \
-                minitest::pri_impl::signal_expectation_failure();                                                  \
-            }                                                                                                      \
-        }                                                                                                          \
-    } while (false)
+// Prints the counters and the count, mean, percentiles and max of the histograms and timers.
+PRI_IMPL_MINITEST_EXPORT void dump_probes(std::ostream &os);
 
-#define MINITEST_EXPECT_NO_THROW(expr, ...)                                                                           \
-    do {                                                                                                              \
-        try                                                                                                           \
-        {                                                                                                             \
-            expr;                                                                                                     \
-        }                                                                                                             \
-        catch (const std::exception &e)                                                                               \
-        {                                                                                                             \
-            PRI_IMPL_PRINT_MESSAGE(std::format("minitest EXPECT_NO_THROW({}) failed: The exception `{}` was thrown.", \
-                                       #expr, minitest::pri_impl::get_type_name(e)),                                  \
-                __VA_ARGS__);                                                                                         \
-            minitest::pri_impl::signal_expectation_failure();                                                         \
-        }                                                                                                             \
-        catch (...)                                                                                                   \
-        {                                                                                                             \
-            PRI_IMPL_PRINT_MESSAGE(                                                                                   \
-                std::format("minitest EXPECT_NO_THROW({}) failed: An unknown exception was thrown.", #expr),          \
-                __VA_ARGS__);                                                                                         \
-            minitest::pri_impl::signal_expectation_failure();                                                         \
-        }                                                                                                             \
-    } while (false)
+// The memory usage of the process in bytes.
+struct memory_usage
+{
+    // the resident set size, 0 if not supported by the platform
+    std::size_t rss = 0;
+    // the peak resident set size since the running test case started on Linux, or since the process started
+    std::size_t peak_rss = 0;
+    // the allocations not deallocated yet, only counted with MINITEST_COUNT_ALLOCATIONS
+    std::uint64_t live_allocations = 0;
+};
+
+// thread-safe
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT memory_usage get_memory_usage();
+
+inline namespace literals
+{
+constexpr std::size_t operator""_KiB(unsigned long long n) { return static_cast<std::size_t>(n) << 10; }
+constexpr std::size_t operator""_MiB(unsigned long long n) { return static_cast<std::size_t>(n) << 20; }
+constexpr std::size_t operator""_GiB(unsigned long long n) { return static_cast<std::size_t>(n) << 30; }
+} // namespace literals
+} // namespace minitest
 
-#define MINITEST_INFO(...)                                                                                       \
+#ifndef MINITEST_CONFIG_DISABLE
+#define PRI_IMPL_MINITEST_DEATH_TEST(macro_name, statement, predicate, regex, on_failure, ...)                     \
     do {                                                                                                         \
-        PRI_IMPL_WIN32_ALLOCATE_CONSOLE_IN_NON_SILENT_MODE();                                                    \
-        __VA_OPT__(std::osyncstream o(std::cout); minitest::pri_impl::print_message(o, __VA_ARGS__); o << '\n';) \
+        auto minitest_death_test_statement = [&] { statement; };                                                 \
+        std::string minitest_death_test_stderr;                                                                  \
+        auto minitest_death_test_status = minitest::pri_impl::run_death_test(                                    \
+            [](void *context) { (*static_cast<decltype(minitest_death_test_statement) *>(context))(); },         \
+            &minitest_death_test_statement, minitest_death_test_stderr);                                         \
+        if ((predicate)(minitest_death_test_status) &&                                                           \
+            minitest::pri_impl::match_death_test_output(minitest_death_test_stderr, regex))                      \
+            break;                                                                                               \
+        PRI_IMPL_PRINT_MESSAGE(std::format("minitest " macro_name "({}) failed: {}", #statement ", " #regex,      \
+                                   minitest::pri_impl::describe_death_test(                                      \
+                                       minitest_death_test_status, minitest_death_test_stderr)),                 \
+            __VA_ARGS__);                                                                                        \
+        on_failure;                                                                                              \
     } while (false)
 
+#define MINITEST_ASSERT_DEATH(statement, regex, ...)                                                       \
+    PRI_IMPL_MINITEST_DEATH_TEST("ASSERT_DEATH", statement, minitest::pri_impl::died, regex,               \
+        PRI_IMPL_MINITEST_FAIL_TEST_CASE(), __VA_ARGS__)
+#define MINITEST_ASSERT_EXIT(statement, predicate, regex, ...)                                             \
+    PRI_IMPL_MINITEST_DEATH_TEST("ASSERT_EXIT", statement, predicate, regex,                               \
+        PRI_IMPL_MINITEST_FAIL_TEST_CASE(), __VA_ARGS__)
+#define MINITEST_EXPECT_DEATH(statement, regex, ...)                                                       \
+    PRI_IMPL_MINITEST_DEATH_TEST("EXPECT_DEATH", statement, minitest::pri_impl::died, regex,               \
+        minitest::pri_impl::signal_expectation_failure(), __VA_ARGS__)
+#define MINITEST_EXPECT_EXIT(statement, predicate, regex, ...)                                             \
+    PRI_IMPL_MINITEST_DEATH_TEST("EXPECT_EXIT", statement, predicate, regex,                               \
+        minitest::pri_impl::signal_expectation_failure(), __VA_ARGS__)
+
+// The probe names must be string literals, a probe is looked up once per call site.
+#define MINITEST_COUNTER_ADD(name, n)                                                                       \
+    do {                                                                                                    \
+        static auto &minitest_probe = minitest::pri_impl::get_counter_probe(name);                          \
+        minitest_probe.add(n);                                                                              \
+    } while (false)
+#define MINITEST_COUNTER(name) MINITEST_COUNTER_ADD(name, 1)
+#define MINITEST_HISTOGRAM(name, value)                                                                     \
+    do {                                                                                                    \
+        static auto &minitest_probe = minitest::pri_impl::get_histogram_probe(name);                        \
+        minitest_probe.record(static_cast<std::uint64_t>(value));                                           \
+    } while (false)
+#define MINITEST_SCOPED_TIMER(name)                                                                         \
+    minitest::pri_impl::scoped_timer PRI_IMPL_MINITEST_UNIQ_NAME(minitest_scoped_timer_, __LINE__)(         \
+        []() -> minitest::pri_impl::histogram_probe & {                                                     \
+            static auto &minitest_probe = minitest::pri_impl::get_timer_probe(name);                        \
+            return minitest_probe;                                                                          \
+        }())
+
+#define PRI_IMPL_MINITEST_COUNTER_EQ(macro_name, name, expected, on_failure, ...)                           \
+    do {                                                                                                    \
+        auto minitest_counter_value = minitest::counter_value(name);                                        \
+        if (minitest_counter_value == static_cast<std::uint64_t>(expected)) break;                          \
+        PRI_IMPL_PRINT_MESSAGE(std::format("minitest " macro_name "({}) failed: The counter is {}.",        \
+                                   #name ", " #expected, minitest_counter_value),                           \
+            __VA_ARGS__);                                                                                   \
+        on_failure;                                                                                         \
+    } while (false)
+#define MINITEST_ASSERT_COUNTER_EQ(name, expected, ...)                                                     \
+    PRI_IMPL_MINITEST_COUNTER_EQ(                                                                           \
+        "ASSERT_COUNTER_EQ", name, expected, PRI_IMPL_MINITEST_FAIL_TEST_CASE(), __VA_ARGS__)
+#define MINITEST_EXPECT_COUNTER_EQ(name, expected, ...)                                                     \
+    PRI_IMPL_MINITEST_COUNTER_EQ(                                                                           \
+        "EXPECT_COUNTER_EQ", name, expected, minitest::pri_impl::signal_expectation_failure(), __VA_ARGS__)
+
+#define PRI_IMPL_MINITEST_PEAK_RSS_BELOW(macro_name, limit, on_failure, ...)                                  \
+    do {                                                                                                      \
+        auto minitest_peak_rss = minitest::get_memory_usage().peak_rss;                                       \
+        if (minitest_peak_rss < static_cast<std::size_t>(limit)) break;                                       \
+        PRI_IMPL_PRINT_MESSAGE(std::format("minitest " macro_name "({}) failed: The peak RSS is {:.1f} MiB.", \
+                                   #limit, minitest_peak_rss / 1048576.0),                                    \
+            __VA_ARGS__);                                                                                     \
+        on_failure;                                                                                           \
+    } while (false)
+#define MINITEST_ASSERT_PEAK_RSS_BELOW(limit, ...) \
+    PRI_IMPL_MINITEST_PEAK_RSS_BELOW("ASSERT_PEAK_RSS_BELOW", limit, PRI_IMPL_MINITEST_FAIL_TEST_CASE(), __VA_ARGS__)
+#define MINITEST_EXPECT_PEAK_RSS_BELOW(limit, ...) \
+    PRI_IMPL_MINITEST_PEAK_RSS_BELOW(              \
+        "EXPECT_PEAK_RSS_BELOW", limit, minitest::pri_impl::signal_expectation_failure(), __VA_ARGS__)
+
+#define PRI_IMPL_MINITEST_MATCHES_SNAPSHOT(macro_name, name, value, on_failure, ...)                    \
+    do {                                                                                                \
+        auto minitest_snapshot_difference = minitest::pri_impl::match_snapshot(                         \
+            PRI_IMPL_MINITEST_LOCATION, name, minitest::pri_impl::snapshot_bytes(value));               \
+        if (minitest_snapshot_difference.empty()) break;                                                \
+        PRI_IMPL_PRINT_MESSAGE(std::format("minitest " macro_name "({}) failed: {}", #name ", " #value, \
+                                   minitest_snapshot_difference),                                       \
+            __VA_ARGS__);                                                                               \
+        on_failure;                                                                                     \
+    } while (false)
+#define MINITEST_ASSERT_MATCHES_SNAPSHOT(name, value, ...)                                                   \
+    PRI_IMPL_MINITEST_MATCHES_SNAPSHOT(                                                                      \
+        "ASSERT_MATCHES_SNAPSHOT", name, value, PRI_IMPL_MINITEST_FAIL_TEST_CASE(), __VA_ARGS__)
+#define MINITEST_EXPECT_MATCHES_SNAPSHOT(name, value, ...)                                                   \
+    PRI_IMPL_MINITEST_MATCHES_SNAPSHOT(                                                                      \
+        "EXPECT_MATCHES_SNAPSHOT", name, value, minitest::pri_impl::signal_expectation_failure(), __VA_ARGS__)
+
+// Replaces the global operator new and delete to count the live allocations. Put it in one source file of the program
+// at the namespace scope.
+#define MINITEST_COUNT_ALLOCATIONS()                                                                                \
+    void *operator new(std::size_t size) { return minitest::pri_impl::counted_allocate(size); }                     \
+    void *operator new[](std::size_t size) { return minitest::pri_impl::counted_allocate(size); }                   \
+    void operator delete(void *p) noexcept { minitest::pri_impl::counted_deallocate(p); }                           \
+    void operator delete[](void *p) noexcept { minitest::pri_impl::counted_deallocate(p); }                         \
+    void operator delete(void *p, std::size_t) noexcept { minitest::pri_impl::counted_deallocate(p); }              \
+    void operator delete[](void *p, std::size_t) noexcept { minitest::pri_impl::counted_deallocate(p); }            \
+    static_assert(true)
+
+#if defined(__linux__) && defined(__GNUC__)
+// Defines the callbacks of -fsanitize-coverage=trace-pc-guard to record the impact index. Put it in one source file of
+// the program at the namespace scope, it replaces the callbacks of the sanitizer runtimes.
+#define MINITEST_RECORD_COVERAGE()                                                                                  \
+    extern "C" PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE void __sanitizer_cov_trace_pc_guard_init(                     \
+        std::uint32_t *start, std::uint32_t *stop)                                                                  \
+    {                                                                                                               \
+        minitest::pri_impl::coverage_guard_init(start, stop);                                                       \
+    }                                                                                                               \
+    extern "C" PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE void __sanitizer_cov_trace_pc_guard(std::uint32_t *guard)     \
+    {                                                                                                               \
+        if (__atomic_load_n(guard, __ATOMIC_RELAXED) && __atomic_exchange_n(guard, 0, __ATOMIC_RELAXED))            \
+        {                                                                                                           \
+            minitest::pri_impl::coverage_guard_hit(reinterpret_cast<std::uintptr_t>(__builtin_return_address(0)));  \
+        }                                                                                                           \
+    }                                                                                                               \
+    static_assert(true)
+// Defines the hooks called by UBSan and TSan after each report, so the reports fail the running test case. Put it in
+// one source file of the program at the namespace scope, it replaces the no-op hooks of the runtimes.
+#define MINITEST_RECORD_SANITIZER_REPORTS()                                                                         \
+    extern "C" void __ubsan_on_report() { minitest::pri_impl::on_sanitizer_report("UndefinedBehaviorSanitizer"); }  \
+    extern "C" void __tsan_on_report(void *) { minitest::pri_impl::on_sanitizer_report("ThreadSanitizer"); }        \
+    static_assert(true)
+#else
+#define MINITEST_RECORD_COVERAGE() static_assert(true)
+#define MINITEST_RECORD_SANITIZER_REPORTS() static_assert(true)
+#endif // defined(__linux__) && defined(__GNUC__)
 #else
-#define MINITEST_SUCCEED(...) (void)0
-#define MINITEST_FAIL(...) (void)0
-#define MINITEST_ASSERT_TRUE(expr, ...) (void)0
-#define MINITEST_ASSERT_FALSE(expr, ...) (void)0
-#define MINITEST_ASSERT_THROW(expr, exception_type, ...) (void)0
-#define MINITEST_ASSERT_NO_THROW(expr, ...) (void)0
-#define MINITEST_EXPECT_TRUE(expr, ...) (void)0
-#define MINITEST_EXPECT_FALSE(expr, ...) (void)0
-#define MINITEST_EXPECT_THROW(expr, exception_type, ...) (void)0
-#define MINITEST_EXPECT_NO_THROW(expr, ...) (void)0
-#define MINITEST_INFO(...) (void)0
+#define MINITEST_ASSERT_DEATH(statement, regex, ...) (void)0
+#define MINITEST_ASSERT_EXIT(statement, predicate, regex, ...) (void)0
+#define MINITEST_EXPECT_DEATH(statement, regex, ...) (void)0
+#define MINITEST_EXPECT_EXIT(statement, predicate, regex, ...) (void)0
+#define MINITEST_COUNTER_ADD(name, n) (void)0
+#define MINITEST_COUNTER(name) (void)0
+#define MINITEST_HISTOGRAM(name, value) (void)0
+#define MINITEST_SCOPED_TIMER(name) (void)0
+#define MINITEST_ASSERT_COUNTER_EQ(name, expected, ...) (void)0
+#define MINITEST_EXPECT_COUNTER_EQ(name, expected, ...) (void)0
+#define MINITEST_ASSERT_PEAK_RSS_BELOW(limit, ...) (void)0
+#define MINITEST_EXPECT_PEAK_RSS_BELOW(limit, ...) (void)0
+#define MINITEST_COUNT_ALLOCATIONS() static_assert(true)
+#define MINITEST_RECORD_COVERAGE() static_assert(true)
+#define MINITEST_RECORD_SANITIZER_REPORTS() static_assert(true)
+#define MINITEST_ASSERT_MATCHES_SNAPSHOT(name, value, ...) (void)0
+#define MINITEST_EXPECT_MATCHES_SNAPSHOT(name, value, ...) (void)0
 #endif // !MINITEST_CONFIG_DISABLE
 
 #ifndef MINITEST_CONFIG_NO_SHORT_NAMES
-#define TEST_CASE(test_case_name) MINITEST_TEST_CASE(test_case_name)
-#define SUCCEED(...) MINITEST_SUCCEED(__VA_ARGS__)
-#define FAIL(...) MINITEST_FAIL(__VA_ARGS__)
-#define ASSERT_TRUE(expr, ...) MINITEST_ASSERT_TRUE(expr, __VA_ARGS__)
-#define ASSERT_FALSE(expr, ...) MINITEST_ASSERT_FALSE(expr, __VA_ARGS__)
-#define ASSERT_THROW(expr, exception_type, ...) MINITEST_ASSERT_THROW(expr, exception_type, __VA_ARGS__)
-#define ASSERT_NO_THROW(expr, ...) MINITEST_ASSERT_NO_THROW(expr, __VA_ARGS__)
-#define EXPECT_TRUE(expr, ...) MINITEST_EXPECT_TRUE(expr, __VA_ARGS__)
-#define EXPECT_FALSE(expr, ...) MINITEST_EXPECT_FALSE(expr, __VA_ARGS__)
-#define EXPECT_THROW(expr, exception_type, ...) MINITEST_EXPECT_THROW(expr, exception_type, __VA_ARGS__)
-#define EXPECT_NO_THROW(expr, ...) MINITEST_EXPECT_NO_THROW(expr, __VA_ARGS__)
-#define INFO(...) MINITEST_INFO(__VA_ARGS__)
-#endif // !MINITEST_CONFIG_NO_SHORT_NAMES
\ No newline at end of file
+#define ASSERT_DEATH(statement, regex, ...) MINITEST_ASSERT_DEATH(statement, regex, __VA_ARGS__)
+#define ASSERT_EXIT(statement, predicate, regex, ...) MINITEST_ASSERT_EXIT(statement, predicate, regex, __VA_ARGS__)
+#define EXPECT_DEATH(statement, regex, ...) MINITEST_EXPECT_DEATH(statement, regex, __VA_ARGS__)
+#define EXPECT_EXIT(statement, predicate, regex, ...) MINITEST_EXPECT_EXIT(statement, predicate, regex, __VA_ARGS__)
+#define ASSERT_COUNTER_EQ(name, expected, ...) MINITEST_ASSERT_COUNTER_EQ(name, expected, __VA_ARGS__)
+#define EXPECT_COUNTER_EQ(name, expected, ...) MINITEST_EXPECT_COUNTER_EQ(name, expected, __VA_ARGS__)
+#define ASSERT_PEAK_RSS_BELOW(limit, ...) MINITEST_ASSERT_PEAK_RSS_BELOW(limit, __VA_ARGS__)
+#define EXPECT_PEAK_RSS_BELOW(limit, ...) MINITEST_EXPECT_PEAK_RSS_BELOW(limit, __VA_ARGS__)
+#define ASSERT_MATCHES_SNAPSHOT(name, value, ...) MINITEST_ASSERT_MATCHES_SNAPSHOT(name, value, __VA_ARGS__)
+#define EXPECT_MATCHES_SNAPSHOT(name, value, ...) MINITEST_EXPECT_MATCHES_SNAPSHOT(name, value, __VA_ARGS__)
+#endif // !MINITEST_CONFIG_NO_SHORT_NAMES
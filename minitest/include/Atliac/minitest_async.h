@@ -0,0 +1,287 @@
+﻿// ==========================================================================
+// minitest - a minimal testing framework for C++
+//
+// Copyright (c) 2024 Atliac
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at https://opensource.org/licenses/MIT
+//
+// The documentation can be found at the library's GitHub repository:
+// https://github.com/Atliac/minitest/blob/main/README.md
+// ==========================================================================
+
+#pragma once
+#include <Atliac/minitest.h>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#ifdef MINITEST_CONFIG_NO_EXCEPTIONS
+#error The async test cases require exceptions, the failures of the tasks are rethrown to their awaiters.
+#endif // MINITEST_CONFIG_NO_EXCEPTIONS
+
+namespace minitest
+{
+template <class T = void> class task;
+
+namespace pri_impl
+{
+// the parts of the promise shared by all task types
+class task_promise_base
+{
+  public:
+    // resumes the awaiting coroutine when the task completes
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+
+        template <class P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            return handle.promise().continuation_;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    void set_continuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+  protected:
+    void rethrow_if_failed() const
+    {
+        if (exception_) { std::rethrow_exception(exception_); }
+    }
+
+  private:
+    std::coroutine_handle<> continuation_ = std::noop_coroutine();
+    std::exception_ptr exception_;
+};
+
+template <class T> class task_promise : public task_promise_base
+{
+  public:
+    task<T> get_return_object();
+
+    void return_value(T value) { value_.emplace(std::move(value)); }
+
+    T result()
+    {
+        rethrow_if_failed();
+        return std::move(*value_);
+    }
+
+  private:
+    std::optional<T> value_;
+};
+
+template <> class task_promise<void> : public task_promise_base
+{
+  public:
+    task<void> get_return_object();
+
+    void return_void() noexcept {}
+
+    void result() { rethrow_if_failed(); }
+};
+} // namespace pri_impl
+
+// A lazily started coroutine, it runs when awaited or run by an event_loop. The exceptions thrown by the coroutine,
+// including minitest_assertion_failure, are rethrown to the awaiter.
+template <class T> class [[nodiscard]] task
+{
+  public:
+    using promise_type = pri_impl::task_promise<T>;
+
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+    task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task &operator=(task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_) { handle_.destroy(); }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task()
+    {
+        if (handle_) { handle_.destroy(); }
+    }
+
+    bool await_ready() const noexcept { return handle_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().set_continuation(awaiting);
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+    [[nodiscard]] std::coroutine_handle<promise_type> handle() const noexcept { return handle_; }
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <class T> task<T> pri_impl::task_promise<T>::get_return_object()
+{
+    return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+inline task<void> pri_impl::task_promise<void>::get_return_object()
+{
+    return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+// A single-threaded event loop with timers and fd readiness (epoll, Linux only). An async test case runs on its own
+// event loop in the thread of the test case. When the event loop is idle, with no timer of steady_clock or fd to wait
+// for, the minitest::clock is advanced to its next timer.
+class PRI_IMPL_MINITEST_EXPORT event_loop
+{
+  public:
+    event_loop();
+    event_loop(const event_loop &) = delete;
+    event_loop &operator=(const event_loop &) = delete;
+    ~event_loop();
+
+    // the event loop running on the current thread, nullptr if none
+    [[nodiscard]] static event_loop *current() noexcept;
+
+    // Run the task, and the tasks it spawns, until the task completes. Returns the result of the task, or rethrows
+    // its exception or the first exception of the spawned tasks.
+    template <class T> T run(task<T> t)
+    {
+        run_until_done(t.handle());
+        return t.await_resume();
+    }
+
+    // Run the task concurrently with the others, the task is destroyed with the event loop if it hasn't completed.
+    void spawn(task<> t);
+
+    void post(std::coroutine_handle<> handle);
+    void add_timer(std::chrono::steady_clock::time_point when, std::coroutine_handle<> handle);
+    void add_timer(clock::time_point when, std::coroutine_handle<> handle);
+    // resumed when no task is ready and no timer is due
+    void add_idle_waiter(std::coroutine_handle<> handle);
+    // only one reader and one writer can wait for a fd at a time
+    void add_fd_waiter(int fd, bool writable, std::coroutine_handle<> handle);
+
+    struct impl;
+
+  private:
+    void run_until_done(std::coroutine_handle<> handle);
+
+    std::unique_ptr<impl> impl_;
+};
+
+namespace pri_impl
+{
+// the event loop running on the current thread, fails the test case if none
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT event_loop &current_event_loop();
+
+inline void run_async_test_case(task<> (*test_case_func)())
+{
+    event_loop loop;
+    loop.run(test_case_func());
+}
+
+template <class Clock> struct timer_awaiter
+{
+    typename Clock::time_point when;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) const { current_event_loop().add_timer(when, handle); }
+
+    void await_resume() const noexcept {}
+};
+
+struct fd_awaiter
+{
+    int fd;
+    bool writable;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        current_event_loop().add_fd_waiter(fd, writable, handle);
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct yield_awaiter
+{
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) const { current_event_loop().post(handle); }
+
+    void await_resume() const noexcept {}
+};
+
+struct idle_awaiter
+{
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) const { current_event_loop().add_idle_waiter(handle); }
+
+    void await_resume() const noexcept {}
+};
+} // namespace pri_impl
+
+// The awaitables below must be awaited on an event loop, e.g. in an async test case.
+[[nodiscard]] inline pri_impl::timer_awaiter<std::chrono::steady_clock> sleep_until(
+    std::chrono::steady_clock::time_point when)
+{
+    return {when};
+}
+
+[[nodiscard]] inline pri_impl::timer_awaiter<clock> sleep_until(clock::time_point when) { return {when}; }
+
+// sleep_for(10ms) waits in real time, sleep_for<minitest::clock>(10ms) waits in virtual time
+template <class Clock = std::chrono::steady_clock>
+[[nodiscard]] pri_impl::timer_awaiter<Clock> sleep_for(typename Clock::duration duration)
+{
+    return {Clock::now() + duration};
+}
+
+[[nodiscard]] inline pri_impl::fd_awaiter wait_readable(int fd) { return {fd, false}; }
+
+[[nodiscard]] inline pri_impl::fd_awaiter wait_writable(int fd) { return {fd, true}; }
+
+// lets the other ready tasks run
+[[nodiscard]] inline pri_impl::yield_awaiter yield() { return {}; }
+
+// lets the other tasks run until none of them is ready and no timer is due, e.g. after minitest::clock::advance()
+[[nodiscard]] inline pri_impl::idle_awaiter run_until_idle() { return {}; }
+} // namespace minitest
+
+#ifndef MINITEST_CONFIG_DISABLE
+#define MINITEST_ASYNC_TEST_CASE(test_case_name, ...)                                             \
+    static minitest::task<> PRI_IMPL_MINITEST_UNIQ_NAME(minitest_async_test_case_f_, __LINE__)(); \
+    MINITEST_TEST_CASE(test_case_name, __VA_ARGS__)                                               \
+    {                                                                                             \
+        minitest::pri_impl::run_async_test_case(                                                  \
+            PRI_IMPL_MINITEST_UNIQ_NAME(minitest_async_test_case_f_, __LINE__));                  \
+    }                                                                                             \
+    static minitest::task<> PRI_IMPL_MINITEST_UNIQ_NAME(minitest_async_test_case_f_, __LINE__)()
+#else
+#define MINITEST_ASYNC_TEST_CASE(test_case_name, ...) \
+    [[maybe_unused]] static minitest::task<> PRI_IMPL_MINITEST_UNIQ_NAME(minitest_async_test_case_f_, __LINE__)()
+#endif // !MINITEST_CONFIG_DISABLE
+
+#ifndef MINITEST_CONFIG_NO_SHORT_NAMES
+#define ASYNC_TEST_CASE(test_case_name, ...) MINITEST_ASYNC_TEST_CASE(test_case_name, __VA_ARGS__)
+#endif // !MINITEST_CONFIG_NO_SHORT_NAMES
@@ -0,0 +1,524 @@
+﻿// ==========================================================================
+// minitest - a minimal testing framework for C++
+//
+// Copyright (c) 2024 Atliac
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at https://opensource.org/licenses/MIT
+//
+// The documentation can be found at the library's GitHub repository:
+// https://github.com/Atliac/minitest/blob/main/README.md
+// ==========================================================================
+
+#pragma once
+// The registration of test cases and fixtures, and the basic assertions. Including this header instead of minitest.h
+// keeps the compile-time cost of test cases low, all formatting is done in minitest.cpp.
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <initializer_list>
+#include <iosfwd>
+#include <type_traits>
+#include <typeinfo>
+
+#if defined(_WIN32) && (!defined(_MSVC_TRADITIONAL) || _MSVC_TRADITIONAL)
+#error The conforming preprocessor is required. Use '/Zc:preprocessor' compiler option to enable it.
+#endif // defined(_WIN32) &&(!defined(_MSVC_TRADITIONAL) || _MSVC_TRADITIONAL)
+
+#if defined(_WIN32) && defined(minitest_SHARED_LIB)
+#ifdef minitest_EXPORTS
+#define PRI_IMPL_MINITEST_EXPORT __declspec(dllexport)
+#else
+#define PRI_IMPL_MINITEST_EXPORT __declspec(dllimport)
+#endif // minitest_EXPORTS
+#else
+#define PRI_IMPL_MINITEST_EXPORT
+#endif // minitest_SHARED_LIB
+
+#define PRI_IMPL_MINITEST_UNIQ_NAME1(name, id) name##id
+#define PRI_IMPL_MINITEST_UNIQ_NAME(name, id) PRI_IMPL_MINITEST_UNIQ_NAME1(name, id)
+
+#define PRI_IMPL_MINITEST_STRINGIFY1(x) #x
+#define PRI_IMPL_MINITEST_STRINGIFY(x) PRI_IMPL_MINITEST_STRINGIFY1(x)
+
+#define MINITEST_SUCCESS 0
+#define MINITEST_FAILURE 1
+// returned by pri_impl::try_run_test when the command line doesn't ask for a test run
+#define PRI_IMPL_MINITEST_NOT_TEST_RUN (-1)
+
+// Without exceptions, e.g. built with -fno-exceptions, a failed assertion longjmps back to the test case runner.
+#if !defined(MINITEST_CONFIG_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(_CPPUNWIND)
+#define MINITEST_CONFIG_NO_EXCEPTIONS
+#endif // !defined(MINITEST_CONFIG_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(_CPPUNWIND)
+
+namespace minitest
+{
+class minitest_assertion_failure : public std::exception
+{
+    using std::exception::exception;
+
+  public:
+    const char *what() const noexcept override { return "minitest assertion failure"; }
+};
+
+PRI_IMPL_MINITEST_EXPORT bool silent_mode();
+
+// The lifetime of a fixture registered with MINITEST_FIXTURE.
+enum class fixture_scope
+{
+    // destroyed when the test case which built it ends
+    test_case,
+    // shared by all test cases run by the process, destroyed when the process exits
+    process
+};
+
+namespace pri_impl
+{
+// exception class meant to be caught and ignored
+class minitest_do_nothing
+{
+};
+
+#ifdef _WIN32
+// thread-safe
+PRI_IMPL_MINITEST_EXPORT void win32_allocate_console();
+#endif // _WIN32
+
+using test_case_function_type = void (*)();
+
+PRI_IMPL_MINITEST_EXPORT void signal_expectation_failure();
+
+class PRI_IMPL_MINITEST_EXPORT auto_reg_test_case
+{
+  public:
+    auto_reg_test_case(const char *test_case_name, test_case_function_type test_case_func,
+        const char *test_case_location, std::initializer_list<const char *> test_case_tags = {});
+};
+
+using fixture_factory_type = void *(*)();
+using fixture_deleter_type = void (*)(void *);
+
+class PRI_IMPL_MINITEST_EXPORT auto_reg_fixture
+{
+  public:
+    auto_reg_fixture(const std::type_info &fixture_type, fixture_scope scope, fixture_factory_type fixture_factory,
+        fixture_deleter_type fixture_deleter, const char *fixture_location);
+};
+
+// thread-safe, builds the fixture on first use
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT const void *get_fixture(const std::type_info &fixture_type);
+
+// throws minitest_do_nothing if the command line doesn't ask for a test run
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT int run_test(int argc, const char *const *argv);
+// returns MINITEST_SUCCESS, MINITEST_FAILURE, or PRI_IMPL_MINITEST_NOT_TEST_RUN if the command line doesn't ask for a
+// test run
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT int try_run_test(int argc, const char *const *argv);
+#ifdef _WIN32
+// same as try_run_test, with the command line of the process
+[[nodiscard]] PRI_IMPL_MINITEST_EXPORT int win32_run_test();
+#endif // _WIN32
+
+// Ends the running test case as failed by a longjmp to the runner, the destructors of the objects of the test case are
+// not called. Aborts the process if no test case runs in the calling thread.
+[[noreturn]] PRI_IMPL_MINITEST_EXPORT void abort_test_case();
+
+template <class T>
+concept message_string = requires(const T &value) {
+    { value.data() } -> std::convertible_to<const char *>;
+    { value.size() } -> std::convertible_to<std::size_t>;
+};
+
+// A type-erased argument of a message. Strings, numbers, pointers and types are printed by minitest.cpp, the other
+// types are printed with their operator<<, which must be declared where the message is used.
+class message_arg
+{
+  public:
+    message_arg(const char *value) noexcept : kind_(kind::c_string), c_string_(value) {}
+    message_arg(std::nullptr_t) noexcept : kind_(kind::null), pointer_(nullptr) {}
+    message_arg(const void *value) noexcept : kind_(kind::pointer), pointer_(value) {}
+    message_arg(bool value) noexcept : kind_(kind::boolean), boolean_(value) {}
+    message_arg(char value) noexcept : kind_(kind::character), character_(value) {}
+    // printed as characters and strings, like the operator<< of the streams
+    message_arg(signed char value) noexcept : kind_(kind::character), character_(static_cast<char>(value)) {}
+    message_arg(unsigned char value) noexcept : kind_(kind::character), character_(static_cast<char>(value)) {}
+    message_arg(const signed char *value) noexcept : message_arg(reinterpret_cast<const char *>(value)) {}
+    message_arg(const unsigned char *value) noexcept : message_arg(reinterpret_cast<const char *>(value)) {}
+    // printed as its demangled name
+    message_arg(const std::type_info &value) noexcept : kind_(kind::type), type_(&value) {}
+
+    template <class T>
+        requires std::is_integral_v<T> && std::is_signed_v<T>
+    message_arg(T value) noexcept : kind_(kind::signed_integer), signed_integer_(value)
+    {
+    }
+
+    template <class T>
+        requires std::is_integral_v<T> && std::is_unsigned_v<T>
+    message_arg(T value) noexcept : kind_(kind::unsigned_integer), unsigned_integer_(value)
+    {
+    }
+
+    template <class T>
+        requires std::is_floating_point_v<T>
+    message_arg(T value) noexcept : kind_(kind::floating_point), floating_point_(value)
+    {
+    }
+
+    template <message_string T>
+    message_arg(const T &value) noexcept : kind_(kind::string), string_{value.data(), value.size()}
+    {
+    }
+
+    template <class T>
+        requires(!message_string<T> && !std::is_arithmetic_v<T> && !std::is_pointer_v<T> && !std::is_array_v<T>)
+    message_arg(const T &value) noexcept
+        : kind_(kind::custom),
+          custom_{&value, [](std::ostream &os, const void *object) { os << *static_cast<const T *>(object); }}
+    {
+    }
+
+    PRI_IMPL_MINITEST_EXPORT void print(std::ostream &os) const;
+
+  private:
+    enum class kind
+    {
+        c_string,
+        null,
+        pointer,
+        boolean,
+        character,
+        type,
+        signed_integer,
+        unsigned_integer,
+        floating_point,
+        string,
+        custom
+    };
+
+    kind kind_;
+    union {
+        const char *c_string_;
+        const void *pointer_;
+        bool boolean_;
+        char character_;
+        const std::type_info *type_;
+        long long signed_integer_;
+        unsigned long long unsigned_integer_;
+        long double floating_point_;
+        struct
+        {
+            const char *data;
+            std::size_t size;
+        } string_;
+        struct
+        {
+            const void *object;
+            void (*print)(std::ostream &os, const void *object);
+        } custom_;
+    };
+};
+
+// thread-safe, prints the message, the custom message if not empty, and the location
+PRI_IMPL_MINITEST_EXPORT void print_message(std::initializer_list<message_arg> message, const char *location,
+    std::initializer_list<message_arg> custom_message);
+
+// thread-safe, prints the message in a line
+PRI_IMPL_MINITEST_EXPORT void print_info(std::initializer_list<message_arg> message);
+
+// Not constexpr on purpose, an assertion failing in a constant evaluation calls it, so the constant evaluation stops
+// at the failing assertion.
+inline void assertion_failed_at_compile_time(const char *) noexcept {}
+} // namespace pri_impl
+
+// Returns the fixture of type `T` registered with MINITEST_FIXTURE. The fixture is built on first use and shared
+// read-only by all users until its scope ends.
+template <class T> const T &fixture() { return *static_cast<const T *>(pri_impl::get_fixture(typeid(T))); }
+} // namespace minitest
+
+#define PRI_IMPL_MINITEST_LOCATION __FILE__ ":" PRI_IMPL_MINITEST_STRINGIFY(__LINE__)
+
+#define PRI_IMPL_PRINT_MESSAGE(msg, ...) \
+    minitest::pri_impl::print_message({msg}, PRI_IMPL_MINITEST_LOCATION, {__VA_ARGS__})
+
+// the failure of an assertion usable in constant evaluations, the message must be a string literal
+#define PRI_IMPL_MINITEST_PRINT_FAILURE(msg, ...)                                                        \
+    do {                                                                                                 \
+        if (std::is_constant_evaluated()) { minitest::pri_impl::assertion_failed_at_compile_time(msg); } \
+        else { PRI_IMPL_PRINT_MESSAGE(msg, __VA_ARGS__); }                                               \
+    } while (false)
+
+#ifdef MINITEST_CONFIG_NO_EXCEPTIONS
+#define PRI_IMPL_MINITEST_FAIL_TEST_CASE() minitest::pri_impl::abort_test_case()
+#else
+#define PRI_IMPL_MINITEST_FAIL_TEST_CASE() throw minitest::minitest_assertion_failure{}
+#endif // MINITEST_CONFIG_NO_EXCEPTIONS
+
+#ifndef MINITEST_CONFIG_DISABLE
+#define MINITEST_RUN_TESTS(argc, argv)                                             \
+    do {                                                                           \
+        int minitest_rt = minitest::pri_impl::try_run_test(argc, argv);            \
+        if (minitest_rt != PRI_IMPL_MINITEST_NOT_TEST_RUN) { return minitest_rt; } \
+    } while (false)
+#else
+#define MINITEST_RUN_TESTS(argc, argv) void(0)
+#endif // !MINITEST_CONFIG_DISABLE
+
+#ifdef _WIN32
+#ifndef MINITEST_CONFIG_DISABLE
+#include <Windows.h>
+#define MINITEST_WIN32_RUN_TESTS()                                                 \
+    do {                                                                           \
+        int minitest_rt = minitest::pri_impl::win32_run_test();                    \
+        if (minitest_rt != PRI_IMPL_MINITEST_NOT_TEST_RUN) { return minitest_rt; } \
+    } while (false)
+#else
+#define MINITEST_WIN32_RUN_TESTS() void(0)
+#endif // !MINITEST_CONFIG_DISABLE
+#endif // _WIN32
+
+#ifndef MINITEST_CONFIG_DISABLE
+#define MINITEST_TEST_CASE(test_case_name, ...)                                                                 \
+    static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)();                                 \
+    static minitest::pri_impl::auto_reg_test_case PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_v_, __LINE__)( \
+        test_case_name, PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__),                           \
+        PRI_IMPL_MINITEST_LOCATION, {__VA_ARGS__});                                                             \
+    static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
+#else
+#define MINITEST_TEST_CASE(test_case_name, ...) \
+    [[maybe_unused]] static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
+#endif // !MINITEST_CONFIG_DISABLE
+
+#ifndef MINITEST_CONFIG_DISABLE
+#define MINITEST_FIXTURE(fixture_type, scope)                                                                   \
+    static minitest::pri_impl::auto_reg_fixture PRI_IMPL_MINITEST_UNIQ_NAME(minitest_fixture_v_, __LINE__)( \
+        typeid(fixture_type), minitest::fixture_scope::scope, []() -> void * { return new fixture_type; },  \
+        [](void *fixture) { delete static_cast<fixture_type *>(fixture); }, PRI_IMPL_MINITEST_LOCATION)
+#else
+#define MINITEST_FIXTURE(fixture_type, scope) static_assert(true)
+#endif // !MINITEST_CONFIG_DISABLE
+
+#ifndef MINITEST_CONFIG_DISABLE
+#define MINITEST_ASSERT_TRUE(expr, ...)                                                         \
+    do {                                                                                        \
+        if (expr) break;                                                                        \
+        PRI_IMPL_MINITEST_PRINT_FAILURE("minitest ASSERT_TRUE(" #expr ") failed", __VA_ARGS__); \
+        PRI_IMPL_MINITEST_FAIL_TEST_CASE();                                                     \
+    } while (false)
+#define MINITEST_ASSERT_FALSE(expr, ...)                                                         \
+    do {                                                                                         \
+        if (!(expr)) break;                                                                      \
+        PRI_IMPL_MINITEST_PRINT_FAILURE("minitest ASSERT_FALSE(" #expr ") failed", __VA_ARGS__); \
+        PRI_IMPL_MINITEST_FAIL_TEST_CASE();                                                      \
+    } while (false)
+#define MINITEST_SUCCEED(...)                                                                             \
+    do {                                                                                                  \
+        if (!std::is_constant_evaluated()) { PRI_IMPL_PRINT_MESSAGE("minitest SUCCEED()", __VA_ARGS__); } \
+    } while (false)
+#define MINITEST_FAIL(...)                                               \
+    do {                                                                 \
+        PRI_IMPL_MINITEST_PRINT_FAILURE("minitest FAIL()", __VA_ARGS__); \
+        PRI_IMPL_MINITEST_FAIL_TEST_CASE();                              \
+    } while (false)
+
+#ifndef MINITEST_CONFIG_NO_EXCEPTIONS
+// the failure messages of the THROW and NO_THROW macros
+#define PRI_IMPL_MINITEST_NOT_THROWN(macro_name, expr, exception_type, ...)                                         \
+    PRI_IMPL_PRINT_MESSAGE("minitest " macro_name "(" #expr ", " #exception_type                                    \
+                           ") failed: The expected exception `" #exception_type "` was not thrown.",                \
+        __VA_ARGS__)
+#define PRI_IMPL_MINITEST_WRONG_EXCEPTION(macro_name, expr, exception_type, e, ...)                                 \
+    minitest::pri_impl::print_message({"minitest " macro_name "(" #expr ", " #exception_type                        \
+                                       ") failed: The exception '",                                                 \
+                                          typeid(e), "' was thrown, but not the expected exception `" #exception_type \
+                                                     "`."},                                                         \
+        PRI_IMPL_MINITEST_LOCATION, {__VA_ARGS__})
+#define PRI_IMPL_MINITEST_UNKNOWN_WRONG_EXCEPTION(macro_name, expr, exception_type, ...)                            \
+    PRI_IMPL_PRINT_MESSAGE("minitest " macro_name "(" #expr ", " #exception_type                                    \
+                           ") failed: An unknown exception was thrown, but not the expected exception `"            \
+                           #exception_type "`.",                                                                    \
+        __VA_ARGS__)
+#define PRI_IMPL_MINITEST_THROWN(macro_name, expr, e, ...)                                                          \
+    minitest::pri_impl::print_message(                                                                              \
+        {"minitest " macro_name "(" #expr ") failed: The exception `", typeid(e), "` was thrown."},                 \
+        PRI_IMPL_MINITEST_LOCATION, {__VA_ARGS__})
+#define PRI_IMPL_MINITEST_UNKNOWN_THROWN(macro_name, expr, ...)                                                     \
+    PRI_IMPL_PRINT_MESSAGE("minitest " macro_name "(" #expr ") failed: An unknown exception was thrown.", __VA_ARGS__)
+
+#define MINITEST_ASSERT_THROW(expr, exception_type, ...)                                                     \
+    do {                                                                                                     \
+        try                                                                                                  \
+        {                                                                                                    \
+            expr;                                                                                            \
+            PRI_IMPL_MINITEST_NOT_THROWN("ASSERT_THROW", expr, exception_type, __VA_ARGS__);                 \
+            throw minitest::minitest_assertion_failure{};                                                    \
+        }                                                                                                    \
+        catch (const minitest::minitest_assertion_failure &)                                                 \
+        {                                                                                                    \
+            throw;                                                                                           \
+        }                                                                                                    \
+        catch (const exception_type &)                                                                       \
+        {                                                                                                    \
+        }                                                                                                    \
+        catch (...)                                                                                          \
+        {                                                                                                    \
+            try                                                                                              \
+            {                                                                                                \
+                std::rethrow_exception(std::current_exception());                                            \
+            }                                                                                                \
+            catch (const std::exception &e)                                                                  \
+            {                                                                                                \
+                PRI_IMPL_MINITEST_WRONG_EXCEPTION("ASSERT_THROW", expr, exception_type, e, __VA_ARGS__);     \
+                throw minitest::minitest_assertion_failure{};                                                \
+            }                                                                                                \
+            catch (...)                                                                                      \
+            {                                                                                                \
+                PRI_IMPL_MINITEST_UNKNOWN_WRONG_EXCEPTION("ASSERT_THROW", expr, exception_type, __VA_ARGS__); \
+                throw minitest::minitest_assertion_failure{};                                                \
+            }                                                                                                \
+        }                                                                                                    \
+    } while (false)
+#define MINITEST_ASSERT_NO_THROW(expr, ...)                                          \
+    do {                                                                             \
+        try                                                                          \
+        {                                                                            \
+            expr;                                                                    \
+        }                                                                            \
+        catch (const std::exception &e)                                              \
+        {                                                                            \
+            PRI_IMPL_MINITEST_THROWN("ASSERT_NO_THROW", expr, e, __VA_ARGS__);       \
+            throw minitest::minitest_assertion_failure{};                            \
+        }                                                                            \
+        catch (...)                                                                  \
+        {                                                                            \
+            PRI_IMPL_MINITEST_UNKNOWN_THROWN("ASSERT_NO_THROW", expr, __VA_ARGS__);  \
+            throw minitest::minitest_assertion_failure{};                            \
+        }                                                                            \
+    } while (false)
+
+#else
+#define MINITEST_ASSERT_THROW(expr, exception_type, ...) \
+    static_assert(false, "minitest: ASSERT_THROW is not available without exceptions")
+#define MINITEST_ASSERT_NO_THROW(expr, ...) \
+    static_assert(false, "minitest: ASSERT_NO_THROW is not available without exceptions")
+#endif // !MINITEST_CONFIG_NO_EXCEPTIONS
+
+#define MINITEST_EXPECT_TRUE(expr, ...)                                                         \
+    do {                                                                                        \
+        if (expr) break;                                                                        \
+        PRI_IMPL_MINITEST_PRINT_FAILURE("minitest EXPECT_TRUE(" #expr ") failed", __VA_ARGS__); \
+        minitest::pri_impl::signal_expectation_failure();                                       \
+    } while (false)
+#define MINITEST_EXPECT_FALSE(expr, ...)                                                         \
+    do {                                                                                         \
+        if (!(expr)) break;                                                                      \
+        PRI_IMPL_MINITEST_PRINT_FAILURE("minitest EXPECT_FALSE(" #expr ") failed", __VA_ARGS__); \
+        minitest::pri_impl::signal_expectation_failure();                                        \
+    } while (false)
+
+#ifndef MINITEST_CONFIG_NO_EXCEPTIONS
+#define MINITEST_EXPECT_THROW(expr, exception_type, ...)                                                     \
+    do {                                                                                                     \
+        try                                                                                                  \
+        {                                                                                                    \
+            expr;                                                                                            \
+            PRI_IMPL_MINITEST_NOT_THROWN("EXPECT_THROW", expr, exception_type, __VA_ARGS__);                 \
+            minitest::pri_impl::signal_expectation_failure();                                                \
+        }                                                                                                    \
+        catch (const exception_type &)                                                                       \
+        {                                                                                                    \
+        }                                                                                                    \
+        catch (...)                                                                                          \
+        {                                                                                                    \
+            try                                                                                              \
+            {                                                                                                \
+                std::rethrow_exception(std::current_exception());                                            \
+            }                                                                                                \
+            catch (const std::exception &e)                                                                  \
+            {                                                                                                \
+                PRI_IMPL_MINITEST_WRONG_EXCEPTION("EXPECT_THROW", expr, exception_type, e, __VA_ARGS__);     \
+                minitest::pri_impl::signal_expectation_failure();                                            \
+            }                                                                                                \
+            catch (...)                                                                                      \
+            {                                                                                                \
+                PRI_IMPL_MINITEST_UNKNOWN_WRONG_EXCEPTION("EXPECT_THROW", expr, exception_type, __VA_ARGS__); \
+                minitest::pri_impl::signal_expectation_failure();                                            \
+            }                                                                                                \
+        }                                                                                                    \
+    } while (false)
+
+#define MINITEST_EXPECT_NO_THROW(expr, ...)                                         \
+    do {                                                                            \
+        try                                                                         \
+        {                                                                           \
+            expr;                                                                   \
+        }                                                                           \
+        catch (const std::exception &e)                                             \
+        {                                                                           \
+            PRI_IMPL_MINITEST_THROWN("EXPECT_NO_THROW", expr, e, __VA_ARGS__);      \
+            minitest::pri_impl::signal_expectation_failure();                       \
+        }                                                                           \
+        catch (...)                                                                 \
+        {                                                                           \
+            PRI_IMPL_MINITEST_UNKNOWN_THROWN("EXPECT_NO_THROW", expr, __VA_ARGS__); \
+            minitest::pri_impl::signal_expectation_failure();                       \
+        }                                                                           \
+    } while (false)
+
+#else
+#define MINITEST_EXPECT_THROW(expr, exception_type, ...) \
+    static_assert(false, "minitest: EXPECT_THROW is not available without exceptions")
+#define MINITEST_EXPECT_NO_THROW(expr, ...) \
+    static_assert(false, "minitest: EXPECT_NO_THROW is not available without exceptions")
+#endif // !MINITEST_CONFIG_NO_EXCEPTIONS
+
+#define MINITEST_INFO(...)                                                                    \
+    do {                                                                                      \
+        if (!std::is_constant_evaluated()) { minitest::pri_impl::print_info({__VA_ARGS__}); } \
+    } while (false)
+
+// The body is evaluated at compile time in a static_assert, and also registered as a runtime test case. Both are
+// function templates, so the static_assert is checked when the runtime test case is instantiated, after the body.
+#define MINITEST_CONSTEXPR_TEST_CASE(test_case_name, ...)                                                           \
+    template <class = void> static constexpr void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)();   \
+    template <class T = void> static void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_r_, __LINE__)()            \
+    {                                                                                                               \
+        static_assert((PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)<T>(), true),                    \
+            "the constexpr test case " test_case_name " failed at compile time");                                   \
+        PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)<T>();                                          \
+    }                                                                                                               \
+    static minitest::pri_impl::auto_reg_test_case PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_v_, __LINE__)(     \
+        test_case_name, PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_r_, __LINE__)<>, PRI_IMPL_MINITEST_LOCATION, \
+        {__VA_ARGS__});                                                                                             \
+    template <class> static constexpr void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
+
+#else
+#define MINITEST_SUCCEED(...) (void)0
+#define MINITEST_FAIL(...) (void)0
+#define MINITEST_ASSERT_TRUE(expr, ...) (void)0
+#define MINITEST_ASSERT_FALSE(expr, ...) (void)0
+#define MINITEST_ASSERT_THROW(expr, exception_type, ...) (void)0
+#define MINITEST_ASSERT_NO_THROW(expr, ...) (void)0
+#define MINITEST_EXPECT_TRUE(expr, ...) (void)0
+#define MINITEST_EXPECT_FALSE(expr, ...) (void)0
+#define MINITEST_EXPECT_THROW(expr, exception_type, ...) (void)0
+#define MINITEST_EXPECT_NO_THROW(expr, ...) (void)0
+#define MINITEST_INFO(...) (void)0
+#define MINITEST_CONSTEXPR_TEST_CASE(test_case_name, ...) \
+    [[maybe_unused]] static constexpr void PRI_IMPL_MINITEST_UNIQ_NAME(minitest_test_case_f_, __LINE__)()
+#endif // !MINITEST_CONFIG_DISABLE
+
+#ifndef MINITEST_CONFIG_NO_SHORT_NAMES
+#define TEST_CASE(test_case_name, ...) MINITEST_TEST_CASE(test_case_name, __VA_ARGS__)
+#define CONSTEXPR_TEST_CASE(test_case_name, ...) MINITEST_CONSTEXPR_TEST_CASE(test_case_name, __VA_ARGS__)
+#define FIXTURE(fixture_type, scope) MINITEST_FIXTURE(fixture_type, scope)
+#define SUCCEED(...) MINITEST_SUCCEED(__VA_ARGS__)
+#define FAIL(...) MINITEST_FAIL(__VA_ARGS__)
+#define ASSERT_TRUE(expr, ...) MINITEST_ASSERT_TRUE(expr, __VA_ARGS__)
+#define ASSERT_FALSE(expr, ...) MINITEST_ASSERT_FALSE(expr, __VA_ARGS__)
+#define ASSERT_THROW(expr, exception_type, ...) MINITEST_ASSERT_THROW(expr, exception_type, __VA_ARGS__)
+#define ASSERT_NO_THROW(expr, ...) MINITEST_ASSERT_NO_THROW(expr, __VA_ARGS__)
+#define EXPECT_TRUE(expr, ...) MINITEST_EXPECT_TRUE(expr, __VA_ARGS__)
+#define EXPECT_FALSE(expr, ...) MINITEST_EXPECT_FALSE(expr, __VA_ARGS__)
+#define EXPECT_THROW(expr, exception_type, ...) MINITEST_EXPECT_THROW(expr, exception_type, __VA_ARGS__)
+#define EXPECT_NO_THROW(expr, ...) MINITEST_EXPECT_NO_THROW(expr, __VA_ARGS__)
+#define INFO(...) MINITEST_INFO(__VA_ARGS__)
+#endif // !MINITEST_CONFIG_NO_SHORT_NAMES
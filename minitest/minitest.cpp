@@ -10,22 +10,89 @@
 // ==========================================================================
 
 #include <Atliac/minitest.h>
+#include <Atliac/minitest_async.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <charconv>
 #include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <coroutine>
 #include <cstring>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
 #include <regex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <syncstream>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #ifdef _WIN32
 #include <Windows.h>
-#include <mutex>
+#include <Psapi.h>
 #include <shellapi.h>
 #endif // _WIN32
+#if !defined(_WIN32) && __has_include(<unistd.h>)
+#define HAS_FORK
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // !defined(_WIN32) && __has_include(<unistd.h>)
+#ifdef HAS_FORK
+#include <sys/resource.h>
+#endif // HAS_FORK
+#if defined(HAS_FORK) && __has_include(<sys/un.h>)
+#define HAS_UNIX_SOCKETS
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif // defined(HAS_FORK) && __has_include(<sys/un.h>)
+#if defined(HAS_FORK) && __has_include(<sys/mman.h>)
+#define HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // defined(HAS_FORK) && __has_include(<sys/mman.h>)
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif // __linux__
+#if defined(__linux__) && defined(__GNUC__)
+// the hooks of the sanitizer runtimes are weak symbols
+#define HAS_SANITIZER_HOOKS
+#include <dlfcn.h>
+#include <link.h>
+#include <spawn.h>
+#endif // defined(__linux__) && defined(__GNUC__)
+#if __has_include(<sys/epoll.h>)
+#define HAS_EPOLL
+#include <sys/epoll.h>
+#endif // __has_include(<sys/epoll.h>)
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif // __has_include(<cxxabi.h>)
 
 using namespace std;
 
@@ -49,10 +116,122 @@ void check_expectation_failure()
     }
 }
 
+// the name of the running test case, the sanitizer reports are attributed to it
+atomic<const char *> running_test_case = nullptr;
+atomic<uint64_t> sanitizer_reports = 0;
+
+#ifdef HAS_SANITIZER_HOOKS
+// set by install_sanitizer_hooks(), the reports are ignored before test cases run
+atomic<bool> sanitizer_hooks_installed = false;
+
+// Called by the hooks of the sanitizer runtimes, possibly in any thread, and with the locks of the runtime held. Writes
+// to stderr directly to keep the order with the reports, without allocating.
+void attribute_sanitizer_report(const char *sanitizer)
+{
+    if (!sanitizer_hooks_installed) { return; }
+    ++sanitizer_reports;
+    char message[512];
+    auto test_case = running_test_case.load();
+    auto size = test_case ? snprintf(message, sizeof(message), "minitest: %s report in the test case: %s\n", sanitizer,
+                                test_case)
+                          : snprintf(message, sizeof(message), "minitest: %s report outside of test cases\n", sanitizer);
+    (void)!write(STDERR_FILENO, message, min<size_t>(size, sizeof(message) - 1));
+}
+
+// installs the callbacks of the sanitizer runtimes once, only when test cases run, the program's own callbacks are kept
+// otherwise
+void install_sanitizer_hooks();
+#endif // HAS_SANITIZER_HOOKS
+
+// Attributes the sanitizer reports to the test case in the scope. The test case is failed by check() if a sanitizer
+// reported an error and recovered, e.g. UBSan by default, or ASan with -fsanitize-recover=address and
+// ASAN_OPTIONS=halt_on_error=0. The reports in a nested test case, run by a test case of the runner itself, are only
+// attributed to the nested one.
+class sanitizer_report_scope
+{
+  public:
+    explicit sanitizer_report_scope(string_view test_case_name)
+        : test_case_name(test_case_name.data()), start(sanitizer_reports), reports_before(start),
+          previous(exchange(current, this))
+    {
+        // the names of the test cases are string literals
+        running_test_case = this->test_case_name;
+    }
+    sanitizer_report_scope(const sanitizer_report_scope &) = delete;
+    sanitizer_report_scope &operator=(const sanitizer_report_scope &) = delete;
+    ~sanitizer_report_scope()
+    {
+        current = previous;
+        running_test_case = previous ? previous->test_case_name : nullptr;
+        if (previous) { previous->reports_before += sanitizer_reports - start; }
+    }
+
+    void check() const
+    {
+        if (auto reports = sanitizer_reports - reports_before)
+        {
+            cout << format("Error: {} sanitizer report{} in the test case", reports, reports > 1 ? "s" : "") << endl;
+            throw minitest::minitest_assertion_failure{};
+        }
+    }
+
+  private:
+    static inline sanitizer_report_scope *current = nullptr;
+    const char *test_case_name;
+    uint64_t start;
+    uint64_t reports_before;
+    sanitizer_report_scope *previous;
+};
+
+atomic<uint64_t> live_allocations = 0;
+// set by the first query of the memory usage, e.g. by flag_check_memory or PEAK_RSS_BELOW, the peak RSS is only reset
+// for the test cases after it
+atomic<bool> tracking_peak_rss = false;
+
+// Resets the peak RSS of the process to the current RSS on Linux, so get_memory_usage() reports the peak of the test
+// case.
+void reset_peak_rss()
+{
+#ifdef __linux__
+    if (!tracking_peak_rss.load(memory_order_relaxed)) { return; }
+    // opened once, -1 if not supported
+    static const int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) { (void)!write(fd, "5", 1); }
+#endif // __linux__
+}
+
+// where minitest::pri_impl::abort_test_case jumps to in this thread
+thread_local jmp_buf *abort_point = nullptr;
+
+// Call the test case code `f`. A failed assertion built without exceptions longjmps back here and is rethrown as
+// minitest_assertion_failure, so the runners handle both the same way.
+void call_with_abort_point(auto &&f)
+{
+    jmp_buf point;
+    auto previous_point = abort_point;
+    if (setjmp(point))
+    {
+        abort_point = previous_point;
+        throw minitest::minitest_assertion_failure{};
+    }
+    abort_point = &point;
+    try
+    {
+        f();
+    }
+    catch (...)
+    {
+        abort_point = previous_point;
+        throw;
+    }
+    abort_point = previous_point;
+}
+
 struct test_case_info
 {
     minitest::pri_impl::test_case_function_type test_case_func = nullptr;
     const char *test_case_location = nullptr;
+    vector<string_view> test_case_tags;
 };
 
 using test_cases_type = map<string_view, test_case_info>;
@@ -63,6 +242,336 @@ auto &get_registered_test_cases()
     return registered_test_cases;
 }
 
+// A set of registered test cases, the nth bit is set if the nth test case of the registry is in the set.
+class test_case_set
+{
+  public:
+    explicit test_case_set(size_t size = 0) : words((size + 63) / 64), num_test_cases(size) {}
+
+    void set(size_t n) { words[n / 64] |= uint64_t(1) << (n % 64); }
+
+    bool test(size_t n) const { return words[n / 64] & (uint64_t(1) << (n % 64)); }
+
+    size_t count() const
+    {
+        size_t num = 0;
+        for (auto word : words) { num += popcount(word); }
+        return num;
+    }
+
+    test_case_set &operator&=(const test_case_set &other)
+    {
+        for (size_t i = 0; i < words.size(); ++i) { words[i] &= other.words[i]; }
+        return *this;
+    }
+
+    test_case_set &operator|=(const test_case_set &other)
+    {
+        for (size_t i = 0; i < words.size(); ++i) { words[i] |= other.words[i]; }
+        return *this;
+    }
+
+    test_case_set operator~() const
+    {
+        auto result = *this;
+        for (auto &word : result.words) { word = ~word; }
+        if (num_test_cases % 64) { result.words.back() &= (uint64_t(1) << (num_test_cases % 64)) - 1; }
+        return result;
+    }
+
+    // call `f` with the index of each test case in the set, in ascending order
+    void for_each(auto &&f) const
+    {
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            for (auto word = words[i]; word; word &= word - 1) { f(i * 64 + countr_zero(word)); }
+        }
+    }
+
+  private:
+    vector<uint64_t> words;
+    size_t num_test_cases;
+};
+
+// The index of the registered test cases, built once when it's first used after all test cases are registered.
+struct test_case_index
+{
+    // the registered test cases in the registry order
+    vector<test_cases_type::iterator> test_cases;
+    // the test cases of each tag
+    map<string_view, test_case_set, less<>> tags;
+
+    test_case_set all() const { return ~test_case_set(test_cases.size()); }
+
+    // the position of the test case, by a binary search of the names in the registry order
+    optional<size_t> find(string_view name) const
+    {
+        auto it = lower_bound(test_cases.begin(), test_cases.end(), name,
+            [](test_cases_type::iterator test_case, string_view value) { return test_case->first < value; });
+        if (it == test_cases.end() || (*it)->first != name) { return nullopt; }
+        return it - test_cases.begin();
+    }
+};
+
+auto &get_test_case_index()
+{
+    static auto index = []
+    {
+        test_case_index index;
+        auto &registered_test_cases = get_registered_test_cases();
+        for (auto it = registered_test_cases.begin(); it != registered_test_cases.end(); ++it)
+        {
+            for (auto tag : it->second.test_case_tags)
+            {
+                index.tags.try_emplace(tag, registered_test_cases.size()).first->second.set(index.test_cases.size());
+            }
+            index.test_cases.push_back(it);
+        }
+        return index;
+    }();
+    return index;
+}
+
+// `*` matches any sequence of characters, `?` matches any single character
+bool glob_match(string_view pattern, string_view text)
+{
+    size_t p = 0, t = 0;
+    auto star = string_view::npos;
+    size_t star_t = 0;
+    while (t < text.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+        {
+            ++p;
+            ++t;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            star_t = t;
+        }
+        else if (star != string_view::npos)
+        {
+            p = star + 1;
+            t = ++star_t;
+        }
+        else { return false; }
+    }
+    while (p < pattern.size() && pattern[p] == '*') { ++p; }
+    return p == pattern.size();
+}
+
+// Evaluates a filter expression against the test case index, the grammar is:
+//   expression := and-expression { "||" and-expression }
+//   and-expression := unary { "&&" unary }
+//   unary := "!" unary | "(" expression ")" | "[" tag "]" | pattern | "\"" pattern "\""
+// A pattern is a glob matched against the test case names, it ends before "&&", "||", ")" or the end of the
+// expression, and the spaces around it are ignored. Quote the pattern if it contains these characters.
+class test_case_filter
+{
+  public:
+    explicit test_case_filter(string_view filter) : filter(filter) {}
+
+    // throws a string describing the syntax error
+    test_case_set evaluate()
+    {
+        auto result = parse_or();
+        skip_spaces();
+        if (pos != filter.size()) { error("unexpected character"); }
+        return result;
+    }
+
+  private:
+    string_view filter;
+    size_t pos = 0;
+    const test_case_index &index = get_test_case_index();
+
+    [[noreturn]] void error(string_view what) const
+    {
+        throw format("minitest: invalid filter, {} at position {}:\n{}\n{:>{}}", what, pos, filter, '^', pos + 1);
+    }
+
+    void skip_spaces()
+    {
+        while (pos < filter.size() && filter[pos] == ' ') { ++pos; }
+    }
+
+    bool consume(string_view token)
+    {
+        skip_spaces();
+        if (!filter.substr(pos).starts_with(token)) { return false; }
+        pos += token.size();
+        return true;
+    }
+
+    test_case_set parse_or()
+    {
+        auto result = parse_and();
+        while (consume("||")) { result |= parse_and(); }
+        return result;
+    }
+
+    test_case_set parse_and()
+    {
+        auto result = parse_unary();
+        while (consume("&&")) { result &= parse_unary(); }
+        return result;
+    }
+
+    test_case_set parse_unary()
+    {
+        if (consume("!")) { return ~parse_unary(); }
+        if (consume("("))
+        {
+            auto result = parse_or();
+            if (!consume(")")) { error("expected ')'"); }
+            return result;
+        }
+        if (consume("["))
+        {
+            auto end = filter.find(']', pos);
+            if (end == string_view::npos) { error("expected ']'"); }
+            auto tag = filter.substr(pos, end - pos);
+            pos = end + 1;
+            auto it = index.tags.find(tag);
+            return it != index.tags.end() ? it->second : test_case_set(index.test_cases.size());
+        }
+        if (consume("\""))
+        {
+            auto end = filter.find('"', pos);
+            if (end == string_view::npos) { error("expected '\"'"); }
+            auto pattern = filter.substr(pos, end - pos);
+            pos = end + 1;
+            return match_names(pattern);
+        }
+        auto end = pos;
+        while (end < filter.size() && filter[end] != ')' && !filter.substr(end).starts_with("&&") &&
+               !filter.substr(end).starts_with("||"))
+        {
+            ++end;
+        }
+        auto pattern = filter.substr(pos, end - pos);
+        while (!pattern.empty() && pattern.back() == ' ') { pattern.remove_suffix(1); }
+        if (pattern.empty()) { error("expected a test case name pattern or a [tag]"); }
+        pos = end;
+        return match_names(pattern);
+    }
+
+    test_case_set match_names(string_view pattern) const
+    {
+        test_case_set result(index.test_cases.size());
+        if (pattern.find_first_of("*?") == string_view::npos)
+        {
+            if (auto test_case_index = index.find(pattern)) { result.set(*test_case_index); }
+            return result;
+        }
+        for (size_t i = 0; i < index.test_cases.size(); ++i)
+        {
+            if (glob_match(pattern, index.test_cases[i]->first)) { result.set(i); }
+        }
+        return result;
+    }
+};
+
+// returns the test cases selected by the filter, or all test cases if the filter is null
+test_case_set select_test_cases(const char *filter)
+{
+    if (!filter) { return get_test_case_index().all(); }
+    return test_case_filter(filter).evaluate();
+}
+
+// call `f` with the test cases selected by the filter, a syntax error of the filter fails the test run
+int with_selected_test_cases(const char *filter, auto &&f)
+{
+    test_case_set selected;
+    try
+    {
+        selected = select_test_cases(filter);
+    }
+    catch (const string &e)
+    {
+        cout << e << endl;
+        return MINITEST_FAILURE;
+    }
+    return f(selected);
+}
+
+// returns the value of the flag, or null if the flag is not specified
+const char *find_flag_value(int argc, const char *const *argv, const char *flag)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (!strcmp(argv[i], flag)) { return argv[i + 1]; }
+    }
+    return nullptr;
+}
+
+struct fixture_info
+{
+    minitest::fixture_scope scope = minitest::fixture_scope::process;
+    minitest::pri_impl::fixture_factory_type fixture_factory = nullptr;
+    minitest::pri_impl::fixture_deleter_type fixture_deleter = nullptr;
+    const char *fixture_location = nullptr;
+    atomic<void *> fixture = nullptr;
+};
+
+struct fixture_registry
+{
+    map<type_index, fixture_info> fixtures;
+    // the fixtures built and not yet destroyed, in the order they were built
+    vector<fixture_info *> built_fixtures;
+    recursive_mutex mutex;
+    // the time spent on building fixtures, see take_fixture_setup_time()
+    chrono::steady_clock::duration setup_time{};
+    // > 0 while a fixture is being built, a fixture may use other fixtures
+    int building_depth = 0;
+
+    // destroy the fixtures of the `scope` in the reverse order they were built
+    void release(minitest::fixture_scope scope)
+    {
+        lock_guard lock(mutex);
+        for (auto it = built_fixtures.rbegin(); it != built_fixtures.rend();)
+        {
+            auto &info = **it;
+            if (info.scope != scope)
+            {
+                ++it;
+                continue;
+            }
+            info.fixture_deleter(info.fixture.exchange(nullptr));
+            it = decltype(it)(built_fixtures.erase(next(it).base()));
+        }
+    }
+
+    ~fixture_registry()
+    {
+        release(minitest::fixture_scope::test_case);
+        release(minitest::fixture_scope::process);
+    }
+};
+
+auto &get_fixture_registry()
+{
+    static fixture_registry registry;
+    return registry;
+}
+
+// returns the time spent on building fixtures since the last call
+auto take_fixture_setup_time()
+{
+    auto &registry = get_fixture_registry();
+    lock_guard lock(registry.mutex);
+    return exchange(registry.setup_time, {});
+}
+
+// destroys the fixtures of the test case scope when the test case ends
+struct test_case_fixtures_guard
+{
+    test_case_fixtures_guard() { take_fixture_setup_time(); }
+
+    ~test_case_fixtures_guard() { get_fixture_registry().release(minitest::fixture_scope::test_case); }
+};
+
 auto elapsed_time_str(chrono::steady_clock::duration elapsed_time)
 {
     chrono::duration<float> s = elapsed_time;
@@ -77,17 +586,31 @@ auto elapsed_time_str(chrono::steady_clock::duration elapsed_time)
         seconds.count() ? format("{}s:", seconds.count()) : "", milliseconds.count());
 }
 
+// run the test case and print the time elapsed, the time spent on building fixtures is reported separately.
+auto run_timed_test_case(string_view test_case_name, minitest::pri_impl::test_case_function_type test_case_func)
+{
+    test_case_fixtures_guard fixtures_guard;
+    sanitizer_report_scope sanitizer_scope(test_case_name);
+    reset_peak_rss();
+    auto start_time = chrono::high_resolution_clock::now();
+    call_with_abort_point(test_case_func);
+    auto end_time = chrono::high_resolution_clock::now();
+    auto fixture_setup_time = take_fixture_setup_time();
+    check_expectation_failure();
+    sanitizer_scope.check();
+    cout << format("{} passed, time elapsed: {}{}", test_case_name,
+                elapsed_time_str(end_time - start_time - fixture_setup_time),
+                fixture_setup_time.count() ? format(", fixture setup: {}", elapsed_time_str(fixture_setup_time)) : "")
+         << endl;
+}
+
 auto run_registered_test_case(string_view test_case_name)
 {
     auto &registered_test_cases = get_registered_test_cases();
     if (registered_test_cases.contains(test_case_name))
     {
         cout << format("Running the test case: {}", test_case_name) << endl;
-        auto start_time = chrono::high_resolution_clock::now();
-        registered_test_cases[test_case_name].test_case_func();
-        auto end_time = chrono::high_resolution_clock::now();
-        check_expectation_failure();
-        cout << format("{} passed, time elapsed: {}", test_case_name, elapsed_time_str(end_time - start_time)) << endl;
+        run_timed_test_case(test_case_name, registered_test_cases[test_case_name].test_case_func);
         return;
     }
     cout << format("Error: failed to find test case {}", test_case_name) << endl;
@@ -105,50 +628,47 @@ auto count_num_width(auto num)
     return num_width;
 }
 
-auto list_registered_test_cases()
+auto list_registered_test_cases(const test_case_set &selected)
 {
-    auto &registered_test_cases = get_registered_test_cases();
-    auto test_case_index = 0;
-    auto test_case_index_width = count_num_width(registered_test_cases.size());
-    for (auto &[name, info] : registered_test_cases)
-    {
-        cout << format("{0:{1}}:{2}({3})", test_case_index++, test_case_index_width, name, info.test_case_location)
-             << endl;
-    }
+    auto &index = get_test_case_index();
+    auto test_case_index_width = count_num_width(index.test_cases.size());
+    selected.for_each(
+        [&](size_t test_case_index)
+        {
+            auto &[name, info] = *index.test_cases[test_case_index];
+            cout << format("{0:{1}}:{2}({3})", test_case_index, test_case_index_width, name, info.test_case_location)
+                 << endl;
+        });
 }
 
-auto pri_impl_run_nth_test_case(size_t nth_test_case_index)
+// the nth test case in the registry order, from the index, so repeated runs don't walk the registry
+auto nth_registered_test_case(size_t nth_test_case_index)
 {
-    auto &registered_test_cases = get_registered_test_cases();
-    if (nth_test_case_index >= registered_test_cases.size())
+    auto &index = get_test_case_index();
+    if (nth_test_case_index >= index.test_cases.size())
     {
-        cout << format("Error: the test case index should be in the range [0, {})", registered_test_cases.size())
-             << endl;
+        cout << format("Error: the test case index should be in the range [0, {})", index.test_cases.size()) << endl;
         throw minitest::minitest_assertion_failure{};
     }
-    auto it = registered_test_cases.begin();
-    advance(it, nth_test_case_index);
-    it->second.test_case_func();
+    return index.test_cases[nth_test_case_index];
+}
+
+auto pri_impl_run_nth_test_case(size_t nth_test_case_index)
+{
+    auto it = nth_registered_test_case(nth_test_case_index);
+    test_case_fixtures_guard fixtures_guard;
+    sanitizer_report_scope sanitizer_scope(it->first);
+    reset_peak_rss();
+    call_with_abort_point(it->second.test_case_func);
     check_expectation_failure();
+    sanitizer_scope.check();
 }
 
 auto run_nth_test_case(size_t nth_test_case_index)
 {
-    auto &registered_test_cases = get_registered_test_cases();
-    if (nth_test_case_index >= registered_test_cases.size())
-    {
-        cout << format("Error: the test case index should be in the range [0, {})", registered_test_cases.size())
-             << endl;
-        throw minitest::minitest_assertion_failure{};
-    }
-    auto it = registered_test_cases.begin();
-    advance(it, nth_test_case_index);
+    auto it = nth_registered_test_case(nth_test_case_index);
     cout << format("Running the {}th test case: {}", nth_test_case_index, it->first) << endl;
-    auto start_time = chrono::high_resolution_clock::now();
-    it->second.test_case_func();
-    auto end_time = chrono::high_resolution_clock::now();
-    check_expectation_failure();
-    cout << format("{} passed, time elapsed: {}", it->first, elapsed_time_str(end_time - start_time)) << endl;
+    run_timed_test_case(it->first, it->second.test_case_func);
 }
 
 // call `f` with `args` to run the test case.
@@ -156,6 +676,9 @@ template <class F, class... Args>
     requires requires(F &&f, Args &&...args) { f(forward<Args>(args)...); }
 [[nodiscard]] int run_test_case(F &&f, Args &&...args)
 {
+#ifdef HAS_SANITIZER_HOOKS
+    install_sanitizer_hooks();
+#endif // HAS_SANITIZER_HOOKS
     if (!silent_mode)
     {
         WIN32_ALLOCATE_CONSOLE();
@@ -193,86 +716,2461 @@ template <class F, class... Args>
     return MINITEST_FAILURE;
 }
 
-// Implement the flag_pri_impl_discover_test_cases flag.
-auto discover_test_case(filesystem::path executable_path, const string &guid, filesystem::path test_config_file)
+#ifdef HAS_FORK
+// fork a child process to run `f`, the child exits with the return value of `f`. The output of the child is
+// discarded if `quiet` is true.
+pid_t fork_child(auto &&f, bool quiet)
 {
-    // read all the content of the test file
-    ifstream ifs(test_config_file);
-    if (!ifs)
-    {
-        cout << format("minitest discover test cases failed: failed to open file {}", test_config_file.string())
-             << endl;
-        return MINITEST_FAILURE;
-    }
-    string content((istreambuf_iterator<char>(ifs)), (istreambuf_iterator<char>()));
-    ifs.close();
-
-    const auto mark_line = format("# {}", guid);
-    // remove the old data
-    // remove the lines between the mark line and the next mark line
-    content = regex_replace(content, regex(format(R"(({}\n)[\s\S]*\1)", mark_line)), "");
-    // remove the lines contain **guid**
-    content = regex_replace(content, regex(format(R"((.*{}.*\n))", guid)), "");
-
-    if (get_registered_test_cases().empty())
+    cout.flush();
+    fflush(nullptr);
+    auto pid = fork();
+    if (pid)
     {
-        cout << "minitest_discover_tests: no test cases found for " << executable_path << endl;
+        if (pid < 0) { cout << format("minitest: fork failed: {}", strerror(errno)) << endl; }
+        return pid;
     }
-    else
+    if (quiet)
     {
-        // append the new data
-        content += mark_line;
-        content += '\n';
-        int test_case_index = 0;
-        for (auto &[name, info] : get_registered_test_cases())
+        if (auto null_fd = open("/dev/null", O_WRONLY); null_fd >= 0)
         {
-
-            content += format(R"(add_test([====[{0}]====] "{1}" {2} "{3}"))", name, executable_path.generic_string(),
-                minitest::pri_impl::flag_pri_impl_run_nth_test_case, test_case_index++);
-            content += '\n';
-            string location = info.test_case_location;
-            // replace the last ':' with ';' in the location
-            auto last_colon = location.find_last_of(':');
-            assert(last_colon != string::npos);
-            location[last_colon] = ';';
-            // replace the '\' with '/' in the location
-            replace(location.begin(), location.end(), '\\', '/');
-            content += format(
-                R"(set_tests_properties([====[{0}]====] PROPERTIES _BACKTRACE_TRIPLES "{1};minitest_discover_tests"))",
-                name, location);
-            content += '\n';
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+            close(null_fd);
         }
-        content += mark_line;
-        content += '\n';
     }
-
-    ofstream ofs(test_config_file);
-    if (!ofs)
+    int code = MINITEST_FAILURE;
+    try
     {
-        cout << format("minitest discover test cases failed: failed to open file {}", test_config_file.string())
-             << endl;
-        return MINITEST_FAILURE;
+        code = f();
     }
-    ofs << content;
-
-    return MINITEST_SUCCESS;
+    catch (...)
+    {
+    }
+    cout.flush();
+    fflush(nullptr);
+    // the child must not run the exit handlers of the parent
+    _exit(code);
 }
 
-} // namespace
+// wait for the child process, returns its exit code, or MINITEST_FAILURE if it is terminated by a signal
+int wait_child(pid_t pid)
+{
+    if (pid < 0) { return MINITEST_FAILURE; }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR) { return MINITEST_FAILURE; }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : MINITEST_FAILURE;
+}
+#endif // HAS_FORK
 
-void minitest::pri_impl::signal_expectation_failure() { expectation_failed = true; }
+chrono::duration<double> death_test_timeout{60};
 
-int minitest::pri_impl::run_test(int argc, const char *const *argv)
+#ifdef HAS_FORK
+// The child of a death test reports through the result pipe whether the statement returned or threw, the stderr
+// output is captured through the output pipe. fork() instead of vfork(), the child runs arbitrary code of the
+// statement, which is undefined behavior in a vfork() child sharing the memory of the parent.
+minitest::death_test_status run_death_test_child(
+    minitest::pri_impl::death_test_statement_type statement, void *context, string &stderr_output)
 {
-    auto &registered_test_cases = get_registered_test_cases();
-
-    if (argc < 1 || !argv || !argv[0])
+    minitest::death_test_status status;
+    int output_pipe[2];
+    int result_pipe[2];
+    if (pipe(output_pipe)) { return status; }
+    if (pipe(result_pipe))
     {
-        cout << "minitest: failed to run test, invalid arguments." << endl;
-        return MINITEST_FAILURE;
+        close(output_pipe[0]);
+        close(output_pipe[1]);
+        return status;
     }
-
-    for (int i = 1; i < argc; ++i)
+    cout.flush();
+    fflush(nullptr);
+    auto pid = fork();
+    if (pid == 0)
+    {
+        close(output_pipe[0]);
+        close(result_pipe[0]);
+        dup2(output_pipe[1], STDERR_FILENO);
+        close(output_pipe[1]);
+        char result = 'r';
+        try
+        {
+            call_with_abort_point([&] { statement(context); });
+        }
+        catch (...)
+        {
+            result = 't';
+        }
+        cout.flush();
+        fflush(nullptr);
+        (void)!write(result_pipe[1], &result, 1);
+        _exit(MINITEST_FAILURE);
+    }
+    close(output_pipe[1]);
+    close(result_pipe[1]);
+    if (pid < 0)
+    {
+        close(output_pipe[0]);
+        close(result_pipe[0]);
+        stderr_output = format("fork failed: {}", strerror(errno));
+        return status;
+    }
+
+    // read both pipes until the child closes them, or kill the child at the deadline
+    string result;
+    pollfd fds[] = {{output_pipe[0], POLLIN, 0}, {result_pipe[0], POLLIN, 0}};
+    auto deadline = chrono::steady_clock::now() + death_test_timeout;
+    for (int open_fds = 2; open_fds;)
+    {
+        auto remaining = chrono::ceil<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (remaining <= 0)
+        {
+            kill(pid, SIGKILL);
+            status.timed_out = true;
+            break;
+        }
+        if (poll(fds, 2, static_cast<int>(min<decltype(remaining)>(remaining, INT32_MAX))) < 0)
+        {
+            if (errno == EINTR) { continue; }
+            kill(pid, SIGKILL);
+            break;
+        }
+        for (auto &fd : fds)
+        {
+            if (fd.fd < 0 || !fd.revents) { continue; }
+            char buffer[4096];
+            auto n = read(fd.fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0)
+            {
+                close(fd.fd);
+                fd.fd = -1;
+                --open_fds;
+                continue;
+            }
+            (&fd == fds ? stderr_output : result).append(buffer, n);
+        }
+    }
+    for (auto &fd : fds)
+    {
+        if (fd.fd >= 0) { close(fd.fd); }
+    }
+
+    int wait_status = 0;
+    while (waitpid(pid, &wait_status, 0) < 0 && errno == EINTR)
+    {
+    }
+    if (status.timed_out) { return status; }
+    status.returned = result == "r";
+    status.threw = result == "t";
+    if (status.returned || status.threw) { return status; }
+    if (WIFEXITED(wait_status))
+    {
+        status.exited = true;
+        status.exit_code = WEXITSTATUS(wait_status);
+    }
+    else if (WIFSIGNALED(wait_status))
+    {
+        status.signaled = true;
+        status.signal = WTERMSIG(wait_status);
+    }
+    return status;
+}
+#endif // HAS_FORK
+
+// The options of the in-process runner, see run_selected_test_cases().
+struct run_options
+{
+    // set by flag_shuffle, the test cases run in the registry order if not set
+    optional<uint64_t> shuffle_seed;
+    // set by flag_detect_order_deps
+    bool detect_order_deps = false;
+    // set by flag_retries, the number of times a failed test case is rerun
+    unsigned retries = 0;
+    // set by flag_repeat, the number of times the test cases run, 0 for no limit
+    uint64_t repeat = 1;
+    // set by flag_until_fail, stop repeating at the first failure
+    bool until_fail = false;
+    // set by flag_flaky_stats
+    optional<filesystem::path> flaky_stats_file;
+    // set by flag_dump_probes
+    bool dump_probes = false;
+    // set by flag_history
+    optional<filesystem::path> history_file;
+    // set by flag_check_memory
+    bool check_memory = false;
+    // set by flag_cpus, sorted
+    vector<unsigned> cpus;
+    // set by flag_numa_node
+    optional<unsigned> numa_node;
+    // set by flag_isolate, raise the priority and lock the memory
+    bool isolate = false;
+    // set by flag_impact_index, recorded unless changed_files is set
+    optional<filesystem::path> impact_index;
+    // set by flag_changed_files, normalized by normal_source_path()
+    optional<vector<string>> changed_files;
+};
+
+// returns the value if the argument is in the form of `flag` or `flag=value`, the value of `flag` is empty
+optional<string_view> parse_flag_option(string_view arg, string_view flag)
+{
+    if (arg == flag) { return string_view(); }
+    if (arg.starts_with(flag) && arg.size() > flag.size() && arg[flag.size()] == '=')
+    {
+        return arg.substr(flag.size() + 1);
+    }
+    return nullopt;
+}
+
+optional<string_view> find_flag_option(int argc, const char *const *argv, string_view flag)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (auto value = parse_flag_option(argv[i], flag)) { return value; }
+    }
+    return nullopt;
+}
+
+// returns whether the argument is an option of the in-process runner, any of them runs the test cases in the process
+bool is_run_option(string_view arg)
+{
+    using namespace minitest::pri_impl;
+    for (auto flag : {flag_shuffle, flag_detect_order_deps, flag_retries, flag_repeat, flag_until_fail, flag_flaky_stats,
+             flag_dump_probes, flag_history, flag_check_memory, flag_update_snapshots, flag_cpus, flag_numa_node,
+             flag_isolate, flag_impact_index, flag_changed_files})
+    {
+        if (parse_flag_option(arg, flag)) { return true; }
+    }
+    return false;
+}
+
+// throws a string if the value of the flag is not a number
+template <class T> T parse_flag_number(string_view flag, string_view value)
+{
+    T number{};
+    auto [end, ec] = from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != errc{} || end != value.data() + value.size())
+    {
+        throw format("minitest: invalid value of {}: {}", flag, value);
+    }
+    return number;
+}
+
+// the CPUs above are rejected, the size of cpu_set_t
+constexpr unsigned max_cpu_count = 1024;
+
+// the CPUs in a list such as `0-3,8`, sorted and unique, throws a string if the list is invalid
+vector<unsigned> parse_cpu_list(string_view flag, string_view list)
+{
+    if (list.empty()) { throw format("minitest: {} requires a list of CPUs", flag); }
+    vector<unsigned> cpus;
+    for (;;)
+    {
+        auto comma = list.find(',');
+        auto range = list.substr(0, comma);
+        auto dash = range.find('-');
+        auto first = parse_flag_number<unsigned>(flag, range.substr(0, dash));
+        auto last = dash == string_view::npos ? first : parse_flag_number<unsigned>(flag, range.substr(dash + 1));
+        if (first > last || last >= max_cpu_count) { throw format("minitest: invalid value of {}: {}", flag, range); }
+        for (auto cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+        if (comma == string_view::npos) { break; }
+        list.remove_prefix(comma + 1);
+    }
+    sort(cpus.begin(), cpus.end());
+    cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+// the path of a source file as it's compared, the changed files are usually relative to the root of the repository
+string normal_source_path(string_view path) { return filesystem::path(path).lexically_normal().generic_string(); }
+
+// whether the recorded source file is the changed file, the changed file may be relative to any directory of it
+bool is_changed_source_file(string_view recorded, string_view changed)
+{
+    auto ends_with_path = [](string_view path, string_view suffix)
+    { return path.size() > suffix.size() && path.ends_with(suffix) && path[path.size() - suffix.size() - 1] == '/'; };
+    return recorded == changed || ends_with_path(recorded, changed) || ends_with_path(changed, recorded);
+}
+
+// throws a string on invalid options
+run_options parse_run_options(int argc, const char *const *argv)
+{
+    run_options options;
+    if (auto seed = find_flag_option(argc, argv, minitest::pri_impl::flag_shuffle))
+    {
+        options.shuffle_seed = seed->empty() ? random_device{}() : parse_flag_number<uint64_t>(
+                                                                       minitest::pri_impl::flag_shuffle, *seed);
+    }
+    options.detect_order_deps = find_flag_option(argc, argv, minitest::pri_impl::flag_detect_order_deps).has_value();
+    if (auto retries = find_flag_option(argc, argv, minitest::pri_impl::flag_retries))
+    {
+        options.retries = parse_flag_number<unsigned>(minitest::pri_impl::flag_retries, *retries);
+    }
+    if (auto repeat = find_flag_option(argc, argv, minitest::pri_impl::flag_repeat))
+    {
+        options.repeat = parse_flag_number<uint64_t>(minitest::pri_impl::flag_repeat, *repeat);
+    }
+    options.until_fail = find_flag_option(argc, argv, minitest::pri_impl::flag_until_fail).has_value();
+    // without a limit, repeat until a failure
+    if (options.until_fail && !find_flag_option(argc, argv, minitest::pri_impl::flag_repeat)) { options.repeat = 0; }
+    if (auto file = find_flag_option(argc, argv, minitest::pri_impl::flag_flaky_stats))
+    {
+        if (file->empty()) { throw format("minitest: {} requires a file", minitest::pri_impl::flag_flaky_stats); }
+        options.flaky_stats_file = *file;
+    }
+    options.dump_probes = find_flag_option(argc, argv, minitest::pri_impl::flag_dump_probes).has_value();
+    if (auto file = find_flag_option(argc, argv, minitest::pri_impl::flag_history))
+    {
+        if (file->empty()) { throw format("minitest: {} requires a file", minitest::pri_impl::flag_history); }
+        options.history_file = *file;
+    }
+    options.check_memory = find_flag_option(argc, argv, minitest::pri_impl::flag_check_memory).has_value();
+    if (auto cpus = find_flag_option(argc, argv, minitest::pri_impl::flag_cpus))
+    {
+        options.cpus = parse_cpu_list(minitest::pri_impl::flag_cpus, *cpus);
+    }
+    if (auto node = find_flag_option(argc, argv, minitest::pri_impl::flag_numa_node))
+    {
+        options.numa_node = parse_flag_number<unsigned>(minitest::pri_impl::flag_numa_node, *node);
+    }
+    options.isolate = find_flag_option(argc, argv, minitest::pri_impl::flag_isolate).has_value();
+    if (auto file = find_flag_option(argc, argv, minitest::pri_impl::flag_impact_index))
+    {
+        if (file->empty()) { throw format("minitest: {} requires a file", minitest::pri_impl::flag_impact_index); }
+        options.impact_index = *file;
+    }
+    if (auto list = find_flag_option(argc, argv, minitest::pri_impl::flag_changed_files))
+    {
+        if (!options.impact_index)
+        {
+            throw format("minitest: {} requires {}=<file>", minitest::pri_impl::flag_changed_files,
+                minitest::pri_impl::flag_impact_index);
+        }
+        // an empty list selects only the test cases not in the index
+        auto &changed_files = options.changed_files.emplace();
+        while (!list->empty())
+        {
+            auto file = list->substr(0, list->find(','));
+            list->remove_prefix(min(list->size(), file.size() + 1));
+            if (!file.empty()) { changed_files.push_back(normal_source_path(file)); }
+        }
+    }
+    // the repeated runs are quiet and keep no per-test-case bookkeeping, see repeat_test_cases()
+    if (options.repeat != 1 || options.until_fail)
+    {
+        using namespace minitest::pri_impl;
+        auto repeat_flag = options.until_fail ? flag_until_fail : flag_repeat;
+        for (auto [flag, set] : {pair{flag_retries, options.retries != 0},
+                 {flag_flaky_stats, options.flaky_stats_file.has_value()},
+                 {flag_history, options.history_file.has_value()}, {flag_check_memory, options.check_memory},
+                 {flag_impact_index, options.impact_index.has_value()},
+                 {flag_detect_order_deps, options.detect_order_deps}})
+        {
+            if (set) { throw format("minitest: {} can't be combined with {}", flag, repeat_flag); }
+        }
+    }
+    return options;
+}
+
+// A Fisher-Yates shuffle driven by mt19937_64 directly, unlike std::shuffle, the order is reproducible with the same
+// seed across standard library implementations.
+void shuffle_test_cases(vector<size_t> &order, uint64_t seed)
+{
+    mt19937_64 engine(seed);
+    for (auto i = order.size(); i > 1; --i) { swap(order[i - 1], order[engine() % i]); }
+}
+
+// The pass/fail history of the test cases, kept in a text file across runs. Each line is
+// `<runs> <failures> <flaky runs> <history> <test case name>`, the bits of the history are the failures of the last 64
+// runs, the lowest bit is the latest run.
+class flaky_stats
+{
+  public:
+    explicit flaky_stats(filesystem::path file) : file(std::move(file))
+    {
+        ifstream ifs(this->file);
+        for (string line; getline(ifs, line);)
+        {
+            if (line.starts_with('#')) { continue; }
+            entry e;
+            int name_pos = 0;
+            if (sscanf(line.c_str(), "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNx64 " %n", &e.runs, &e.failures,
+                    &e.flaky_runs, &e.history, &name_pos) == 4 &&
+                name_pos)
+            {
+                entries[line.substr(name_pos)] = e;
+            }
+        }
+    }
+
+    // `failed` is whether the first run failed, `flaky` is whether it passed on a retry
+    void record(string_view test_case_name, bool failed, bool flaky)
+    {
+        auto &e = entries[string(test_case_name)];
+        ++e.runs;
+        e.failures += failed;
+        e.flaky_runs += flaky;
+        e.history = e.history << 1 | failed;
+    }
+
+    void print(string_view test_case_name) const
+    {
+        auto it = entries.find(test_case_name);
+        if (it == entries.end()) { return; }
+        auto &e = it->second;
+        auto recent_runs = min<uint64_t>(e.runs, 64);
+        // Laplace's rule of succession, an estimate that doesn't jump to 0% or 100% after a few runs
+        cout << format("    {}: failure rate {:.1f}% ({} of {} runs failed, {} flaky), last {} runs {:.1f}%",
+                    test_case_name, 100.0 * (e.failures + 1) / (e.runs + 2), e.failures, e.runs, e.flaky_runs,
+                    recent_runs, 100.0 * popcount(e.history & (recent_runs == 64 ? ~0ull : (1ull << recent_runs) - 1)) /
+                                     recent_runs)
+             << endl;
+    }
+
+    void save() const
+    {
+        ofstream ofs(file);
+        if (!ofs)
+        {
+            cout << format("minitest: failed to write the flaky stats file {}", file.string()) << endl;
+            return;
+        }
+        ofs << "# minitest flaky stats: <runs> <failures> <flaky runs> <history> <test case name>\n";
+        for (auto &[name, e] : entries)
+        {
+            ofs << format("{} {} {} {:x} {}\n", e.runs, e.failures, e.flaky_runs, e.history, name);
+        }
+    }
+
+  private:
+    struct entry
+    {
+        uint64_t runs = 0;
+        uint64_t failures = 0;
+        uint64_t flaky_runs = 0;
+        uint64_t history = 0;
+    };
+
+    filesystem::path file;
+    map<string, entry, less<>> entries;
+};
+
+// The history database of flag_history, an append-only binary file in the native byte order. The header is followed
+// by 32-byte records: a result per test case run, and a name record, followed by the name padded to whole records,
+// the first time a test case is recorded. The test cases are identified by the FNV-1a hashes of their names, so a
+// report is one sequential scan of the mapped file.
+struct history_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t reserved[2];
+};
+
+enum history_record_kind : uint32_t
+{
+    history_passed,
+    history_failed,
+    // failed, then passed on a retry
+    history_flaky,
+    history_name
+};
+
+struct history_record
+{
+    // the FNV-1a hash of the test case name
+    uint64_t test_id;
+    // the start time of the test run in nanoseconds since the epoch
+    uint64_t run_id;
+    // the duration in nanoseconds for a result, the length of the name for a name record
+    uint64_t value;
+    history_record_kind kind;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(history_header) == 32 && sizeof(history_record) == 32);
+
+constexpr char history_magic[8] = {'m', 'i', 'n', 'i', 't', 'e', 's', 't'};
+constexpr uint32_t history_version = 1;
+
+uint64_t fnv1a_hash(string_view s)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : s) { hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull; }
+    return hash;
+}
+
+// A read-only view of the content of a file, mapped if supported. Empty if the file doesn't exist.
+class file_view
+{
+  public:
+    explicit file_view(const filesystem::path &file)
+    {
+#ifdef HAS_MMAP
+        auto fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0) { return; }
+        struct stat file_stat;
+        if (!fstat(fd, &file_stat) && file_stat.st_size > 0)
+        {
+            auto data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<const char *>(data);
+                size_ = file_stat.st_size;
+            }
+        }
+        close(fd);
+#else
+        ifstream ifs(file, ios::binary);
+        buffer.assign(istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+        data_ = buffer.data();
+        size_ = buffer.size();
+#endif // HAS_MMAP
+    }
+
+    file_view(const file_view &) = delete;
+    file_view &operator=(const file_view &) = delete;
+
+    ~file_view()
+    {
+#ifdef HAS_MMAP
+        if (data_) { munmap(const_cast<char *>(data_), size_); }
+#endif // HAS_MMAP
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+#ifndef HAS_MMAP
+    vector<char> buffer;
+#endif // !HAS_MMAP
+};
+
+// Calls `on_name(test_id, name)` and `on_result(record)` in the order of the records. Returns false if the file isn't
+// a history file. An incomplete record at the end, left by an interrupted append, is ignored.
+bool scan_history(const file_view &file, auto &&on_name, auto &&on_result)
+{
+    if (!file.size()) { return true; }
+    history_header header;
+    if (file.size() < sizeof(header)) { return false; }
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, history_magic, sizeof(history_magic)) || header.version != history_version ||
+        header.record_size != sizeof(history_record))
+    {
+        return false;
+    }
+    for (auto offset = sizeof(header); offset + sizeof(history_record) <= file.size();)
+    {
+        history_record record;
+        memcpy(&record, file.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.kind != history_name)
+        {
+            on_result(record);
+            continue;
+        }
+        auto padded_size = (record.value + sizeof(record) - 1) / sizeof(record) * sizeof(record);
+        if (padded_size > file.size() - offset) { break; }
+        on_name(record.test_id, string_view(file.data() + offset, record.value));
+        offset += padded_size;
+    }
+    return true;
+}
+
+// the results of a test run, appended to the history file at the end of the run
+class test_history
+{
+  public:
+    explicit test_history(filesystem::path file)
+        : file(std::move(file)),
+          run_id(chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count())
+    {
+    }
+
+    void record(string_view test_case_name, history_record_kind kind, chrono::nanoseconds duration)
+    {
+        auto test_id = fnv1a_hash(test_case_name);
+        names.emplace(test_id, test_case_name);
+        results.push_back({test_id, run_id, static_cast<uint64_t>(duration.count()), kind, 0});
+    }
+
+    // Appends the results and the names not in the file yet with a single write.
+    void save() const
+    {
+        unordered_set<uint64_t> known_test_ids;
+        file_view view(file);
+        if (!scan_history(view, [&](uint64_t test_id, string_view) { known_test_ids.insert(test_id); },
+                [](const history_record &) {}))
+        {
+            cout << format("minitest: {} is not a minitest history file", file.string()) << endl;
+            return;
+        }
+        string buffer;
+        auto append = [&](const auto &value) { buffer.append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+        if (!view.size())
+        {
+            history_header header{};
+            memcpy(header.magic, history_magic, sizeof(history_magic));
+            header.version = history_version;
+            header.record_size = sizeof(history_record);
+            append(header);
+        }
+        for (auto &[test_id, name] : names)
+        {
+            if (known_test_ids.contains(test_id)) { continue; }
+            append(history_record{test_id, run_id, name.size(), history_name, 0});
+            buffer += name;
+            buffer.resize((buffer.size() + sizeof(history_record) - 1) / sizeof(history_record) * sizeof(history_record));
+        }
+        for (auto &result : results) { append(result); }
+        ofstream ofs(file, ios::binary | ios::app);
+        ofs.write(buffer.data(), buffer.size());
+        if (!ofs) { cout << format("minitest: failed to write the history file {}", file.string()) << endl; }
+    }
+
+  private:
+    filesystem::path file;
+    uint64_t run_id;
+    map<uint64_t, string_view> names;
+    vector<history_record> results;
+};
+
+// A test case drifted if the median duration of its last runs is well above the median of the runs before them. The
+// threshold is both relative and absolute, the durations of fast test cases are dominated by noise.
+constexpr size_t history_drift_window = 10;
+constexpr double history_drift_ratio = 1.25;
+constexpr uint64_t history_drift_min_ns = 100'000;
+
+string duration_str(uint64_t nanoseconds) { return format("{:.3f}ms", nanoseconds / 1e6); }
+
+// the nearest-rank percentile of the sorted values
+uint64_t percentile(const vector<uint64_t> &sorted, double p)
+{
+    auto rank = static_cast<size_t>(ceil(p * sorted.size()));
+    return sorted[rank ? rank - 1 : 0];
+}
+
+uint64_t median(vector<uint64_t> values)
+{
+    auto middle = values.begin() + values.size() / 2;
+    nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+// Implement the flag_history_report flag, fails if any test case drifted.
+int report_history(const filesystem::path &file)
+{
+    if (!filesystem::exists(file))
+    {
+        cout << format("minitest: the history file {} doesn't exist", file.string()) << endl;
+        return MINITEST_FAILURE;
+    }
+    struct test_case_history
+    {
+        // empty if the name record is lost
+        string_view name;
+        // in the order of the runs
+        vector<uint64_t> durations;
+        uint64_t failures = 0;
+        uint64_t flaky_runs = 0;
+    };
+    auto start_time = chrono::steady_clock::now();
+    file_view view(file);
+    unordered_map<uint64_t, test_case_history> histories;
+    unordered_set<uint64_t> run_ids;
+    // the results of a run are consecutive
+    optional<uint64_t> last_run_id;
+    if (!scan_history(
+            view, [&](uint64_t test_id, string_view name) { histories[test_id].name = name; },
+            [&](const history_record &record)
+            {
+                auto &history = histories[record.test_id];
+                history.durations.push_back(record.value);
+                history.failures += record.kind == history_failed;
+                history.flaky_runs += record.kind == history_flaky;
+                if (record.run_id != last_run_id) { run_ids.insert(*(last_run_id = record.run_id)); }
+            }))
+    {
+        cout << format("minitest: {} is not a minitest history file", file.string()) << endl;
+        return MINITEST_FAILURE;
+    }
+
+    vector<test_case_history *> sorted_histories;
+    vector<string> unknown_names;
+    unknown_names.reserve(histories.size());
+    for (auto &[test_id, history] : histories)
+    {
+        if (history.durations.empty()) { continue; }
+        if (history.name.empty()) { history.name = unknown_names.emplace_back(format("<unknown {:016x}>", test_id)); }
+        sorted_histories.push_back(&history);
+    }
+    sort(sorted_histories.begin(), sorted_histories.end(), [](auto a, auto b) { return a->name < b->name; });
+    cout << format("minitest: {} test run{} of {} test case{} in {}", run_ids.size(), run_ids.size() > 1 ? "s" : "",
+                sorted_histories.size(), sorted_histories.size() > 1 ? "s" : "", file.string())
+         << endl;
+    vector<string> drifts;
+    for (auto history : sorted_histories)
+    {
+        auto &durations = history->durations;
+        if (durations.size() >= 2 * history_drift_window)
+        {
+            auto recent_begin = durations.end() - history_drift_window;
+            auto baseline = median(vector<uint64_t>(durations.begin(), recent_begin));
+            auto recent = median(vector<uint64_t>(recent_begin, durations.end()));
+            if (recent > baseline * history_drift_ratio && recent - baseline > history_drift_min_ns)
+            {
+                drifts.push_back(format("Drifted: {}, p50 {} -> {} (+{:.1f}%)", history->name, duration_str(baseline),
+                    duration_str(recent), 100.0 * (recent - baseline) / max<uint64_t>(baseline, 1)));
+            }
+        }
+        sort(durations.begin(), durations.end());
+        cout << format("    {}: {} runs, {} failed, {} flaky, p50 {}, p90 {}, p99 {}, max {}", history->name,
+                    durations.size(), history->failures, history->flaky_runs, duration_str(percentile(durations, 0.5)),
+                    duration_str(percentile(durations, 0.9)), duration_str(percentile(durations, 0.99)),
+                    duration_str(durations.back()))
+             << endl;
+    }
+    for (auto &drift : drifts) { cout << drift << endl; }
+    cout << format("minitest: {} bytes scanned, time elapsed: {}", view.size(),
+                elapsed_time_str(chrono::steady_clock::now() - start_time))
+         << endl;
+    return drifts.empty() ? MINITEST_SUCCESS : MINITEST_FAILURE;
+}
+
+// set by flag_update_snapshots, the snapshots are written instead of compared
+atomic<bool> updating_snapshots{false};
+// the number of the context lines around the difference of a snapshot, and the number of the differing lines shown
+constexpr size_t snapshot_diff_context = 3;
+constexpr size_t snapshot_diff_max_lines = 40;
+
+// the lines of the text, each with its line break
+vector<string_view> split_lines(string_view text)
+{
+    vector<string_view> lines;
+    while (!text.empty())
+    {
+        auto end = text.find('\n');
+        end = end == string_view::npos ? text.size() : end + 1;
+        lines.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+    }
+    return lines;
+}
+
+// A compact unified diff with one hunk, from the first to the last differing line.
+string diff_snapshot(const filesystem::path &file, string_view expected, string_view actual)
+{
+    if (expected.find('\0') != string_view::npos || actual.find('\0') != string_view::npos)
+    {
+        auto [differing, _] = mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+        return format("The content differs from {} at the byte {}, {} bytes expected, {} bytes actual.", file.string(),
+            differing - expected.begin(), expected.size(), actual.size());
+    }
+    auto expected_lines = split_lines(expected);
+    auto actual_lines = split_lines(actual);
+    size_t prefix = 0;
+    while (prefix < expected_lines.size() && prefix < actual_lines.size() &&
+           expected_lines[prefix] == actual_lines[prefix])
+    {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < expected_lines.size() - prefix && suffix < actual_lines.size() - prefix &&
+           expected_lines[expected_lines.size() - 1 - suffix] == actual_lines[actual_lines.size() - 1 - suffix])
+    {
+        ++suffix;
+    }
+    auto begin = prefix - min(prefix, snapshot_diff_context);
+    auto context_after = min(suffix, snapshot_diff_context);
+    auto expected_end = expected_lines.size() - suffix;
+    auto actual_end = actual_lines.size() - suffix;
+
+    auto description = format("The content differs from the snapshot:\n--- {}\n+++ actual\n@@ -{},{} +{},{} @@\n",
+        file.string(), begin + 1, expected_end + context_after - begin, begin + 1, actual_end + context_after - begin);
+    auto append_line = [&](char prefix_char, string_view line)
+    {
+        description += prefix_char;
+        description += line;
+        if (!line.ends_with('\n')) { description += "\n\\ No newline at end of file\n"; }
+    };
+    auto append_lines = [&](char prefix_char, const vector<string_view> &lines, size_t first, size_t last)
+    {
+        for (auto i = first; i < min(last, first + snapshot_diff_max_lines); ++i) { append_line(prefix_char, lines[i]); }
+        if (last - first > snapshot_diff_max_lines)
+        {
+            description += format("... {} more lines\n", last - first - snapshot_diff_max_lines);
+        }
+    };
+    append_lines(' ', expected_lines, begin, prefix);
+    append_lines('-', expected_lines, prefix, expected_end);
+    append_lines('+', actual_lines, prefix, actual_end);
+    append_lines(' ', expected_lines, expected_end, expected_end + context_after);
+    description.pop_back();
+    return description;
+}
+
+// writes the snapshot to a temporary file and renames it, so an interrupted update doesn't leave a partial snapshot
+string update_snapshot(const filesystem::path &file, string_view content)
+{
+    error_code ec;
+    filesystem::create_directories(file.parent_path(), ec);
+    auto temp_file = filesystem::path(file).concat(".tmp");
+    {
+        ofstream ofs(temp_file, ios::binary | ios::trunc);
+        ofs.write(content.data(), static_cast<streamsize>(content.size()));
+        if (!ofs.flush()) { return format("Failed to write the snapshot {}.", temp_file.string()); }
+    }
+    filesystem::rename(temp_file, file, ec);
+    if (ec) { return format("Failed to update the snapshot {}: {}", file.string(), ec.message()); }
+    cout << format("minitest: updated the snapshot {}", file.string()) << endl;
+    return {};
+}
+
+// The coverage of -fsanitize-coverage=trace-pc-guard, recorded per test case for the test impact index through the
+// callbacks of MINITEST_RECORD_COVERAGE(). The guards are zero, which disables them, except while a test case is
+// recorded, then each guard records the PC of its first hit. The callbacks run before the dynamic initialization of
+// this file, only constant-initialized variables are used.
+uintptr_t *coverage_hits = nullptr;
+size_t coverage_hit_capacity = 0;
+atomic<size_t> coverage_hit_count{0};
+
+// the guards of the instrumented modules
+auto &coverage_guard_sections()
+{
+    static vector<pair<uint32_t *, uint32_t *>> sections;
+    return sections;
+}
+
+const string_view impact_index_header = "minitest impact index 1";
+
+#ifdef HAS_SANITIZER_HOOKS
+// the source files of the PCs, by the symbolizer of a sanitizer runtime if linked, or by addr2line with the debug
+// information of the modules
+unordered_map<uintptr_t, string> source_files(const vector<uintptr_t> &pcs);
+#endif // HAS_SANITIZER_HOOKS
+
+// Records the source files each test case executes, and saves them as the impact index: the header line, the number of
+// the files, a line for each file, then a line for each test case, `<file indexes separated by spaces>\t<name>`.
+class impact_recorder
+{
+  public:
+    impact_recorder()
+    {
+        size_t guard_count = 0;
+        for (auto [start, stop] : coverage_guard_sections()) { guard_count += stop - start; }
+        // each guard records once in a test case
+        hits.resize(guard_count);
+        coverage_hits = hits.data();
+        coverage_hit_capacity = hits.size();
+    }
+
+    impact_recorder(const impact_recorder &) = delete;
+    impact_recorder &operator=(const impact_recorder &) = delete;
+
+    ~impact_recorder()
+    {
+        set_guards(0);
+        coverage_hit_capacity = 0;
+        coverage_hits = nullptr;
+    }
+
+    static bool instrumented() { return !coverage_guard_sections().empty(); }
+
+    void begin()
+    {
+        coverage_hit_count = 0;
+        set_guards(1);
+    }
+
+    void end(string_view test_case_name)
+    {
+        set_guards(0);
+        auto count = min(coverage_hit_count.load(), hits.size());
+        test_cases.emplace_back(test_case_name, vector<uintptr_t>(hits.begin(), hits.begin() + count));
+    }
+
+    void save(const filesystem::path &file) const
+    {
+        unordered_set<uintptr_t> unique_pcs;
+        for (auto &[name, pcs] : test_cases) { unique_pcs.insert(pcs.begin(), pcs.end()); }
+        unordered_map<uintptr_t, string> files_of_pcs;
+#ifdef HAS_SANITIZER_HOOKS
+        files_of_pcs = source_files(vector<uintptr_t>(unique_pcs.begin(), unique_pcs.end()));
+#endif // HAS_SANITIZER_HOOKS
+        unordered_map<string, size_t> file_indexes;
+        vector<string_view> files;
+        string content;
+        for (auto &[name, pcs] : test_cases)
+        {
+            set<size_t> indexes;
+            for (auto pc : pcs)
+            {
+                auto source_file = files_of_pcs.find(pc);
+                if (source_file == files_of_pcs.end()) { continue; }
+                auto [it, inserted] = file_indexes.try_emplace(source_file->second, files.size());
+                if (inserted) { files.push_back(it->first); }
+                indexes.insert(it->second);
+            }
+            auto separator = "";
+            for (auto index : indexes) { content += format("{}{}", exchange(separator, " "), index); }
+            content += format("\t{}\n", name);
+        }
+        ofstream ofs(file, ios::trunc);
+        ofs << impact_index_header << '\n' << files.size() << '\n';
+        for (auto source_file : files) { ofs << source_file << '\n'; }
+        ofs << content;
+        if (!ofs.flush())
+        {
+            cout << format("minitest: failed to write the impact index {}", file.string()) << endl;
+            return;
+        }
+        cout << format("minitest: recorded the source files of {} test case{} in the impact index {}, {} of {} "
+                       "executed code locations are mapped to {} source file{}",
+                    test_cases.size(), test_cases.size() > 1 ? "s" : "", file.string(), files_of_pcs.size(),
+                    unique_pcs.size(), files.size(), files.size() > 1 ? "s" : "")
+             << endl;
+    }
+
+  private:
+    static void set_guards(uint32_t value)
+    {
+        for (auto [start, stop] : coverage_guard_sections())
+        {
+            for (auto guard = start; guard != stop; ++guard)
+            {
+                atomic_ref<uint32_t>(*guard).store(value, memory_order_relaxed);
+            }
+        }
+    }
+
+    vector<uintptr_t> hits;
+    // the PCs executed by each test case, in the order they ran
+    vector<pair<string, vector<uintptr_t>>> test_cases;
+};
+
+// Implement the flag_changed_files flag, returns the selected test cases which executed any of the changed files, and
+// those not in the impact index, e.g. new test cases. Returns nullopt if the index can't be read.
+optional<test_case_set> select_impacted_test_cases(
+    const test_case_set &selected, const filesystem::path &index_file, const vector<string> &changed_files)
+{
+    ifstream ifs(index_file);
+    string line;
+    size_t file_count = 0;
+    if (!getline(ifs, line) || line != impact_index_header || !(ifs >> file_count) || !getline(ifs, line))
+    {
+        cout << format("minitest: {} is not a minitest impact index", index_file.string()) << endl;
+        return nullopt;
+    }
+    vector<bool> changed(file_count);
+    for (size_t i = 0; i < file_count && getline(ifs, line); ++i)
+    {
+        changed[i] = any_of(changed_files.begin(), changed_files.end(),
+            [&](const string &changed_file) { return is_changed_source_file(line, changed_file); });
+    }
+    map<string, bool, less<>> impacted;
+    while (getline(ifs, line))
+    {
+        auto tab = line.find('\t');
+        if (tab == string::npos) { continue; }
+        auto &test_case_impacted = impacted[line.substr(tab + 1)];
+        istringstream indexes(line.substr(0, tab));
+        for (size_t index; indexes >> index;)
+        {
+            test_case_impacted = test_case_impacted || (index < file_count && changed[index]);
+        }
+    }
+
+    auto &index = get_test_case_index();
+    test_case_set result(index.test_cases.size());
+    size_t new_test_cases = 0;
+    selected.for_each(
+        [&](size_t test_case_index)
+        {
+            auto test_case = impacted.find(index.test_cases[test_case_index]->first);
+            if (test_case == impacted.end()) { ++new_test_cases; }
+            if (test_case == impacted.end() || test_case->second) { result.set(test_case_index); }
+        });
+    cout << format("minitest: {} of {} test case{} impacted by the changed files, {} of them not in the impact index",
+                result.count(), selected.count(), selected.count() > 1 ? "s are" : " is", new_test_cases)
+         << endl;
+    return result;
+}
+
+// rerun a failed test case, in a child process if supported so it doesn't see the state the failure left behind
+int rerun_test_case(size_t test_case_index)
+{
+#ifdef HAS_FORK
+    return wait_child(fork_child(
+        [&]
+        {
+            ::silent_mode = true;
+            return run_test_case(pri_impl_run_nth_test_case, test_case_index);
+        },
+        false));
+#else
+    return run_test_case(run_registered_test_case, get_test_case_index().test_cases[test_case_index]->first);
+#endif // HAS_FORK
+}
+
+// run the test cases one by one in the order, returns the failed test cases
+vector<size_t> run_test_cases_in_order(const vector<size_t> &order, const run_options &options)
+{
+    auto &index = get_test_case_index();
+    optional<flaky_stats> stats;
+    if (options.flaky_stats_file) { stats.emplace(*options.flaky_stats_file); }
+    optional<test_history> history;
+    if (options.history_file) { history.emplace(*options.history_file); }
+    optional<impact_recorder> impact;
+    if (options.impact_index && !options.changed_files) { impact.emplace(); }
+    vector<size_t> failed_test_cases;
+    vector<size_t> flaky_test_cases;
+    // the test cases with more live allocations after they ran, and the number of the allocations
+    vector<pair<size_t, int64_t>> leaking_test_cases;
+    for (auto test_case_index : order)
+    {
+        auto test_case_name = index.test_cases[test_case_index]->first;
+        auto memory_before = options.check_memory ? minitest::get_memory_usage() : minitest::memory_usage{};
+        if (impact) { impact->begin(); }
+        auto start_time = chrono::steady_clock::now();
+        auto rt = run_test_case(run_registered_test_case, test_case_name);
+        auto duration = chrono::steady_clock::now() - start_time;
+        if (impact) { impact->end(test_case_name); }
+        if (options.check_memory)
+        {
+            auto memory_after = minitest::get_memory_usage();
+            auto leaked_allocations =
+                static_cast<int64_t>(memory_after.live_allocations - memory_before.live_allocations);
+            cout << format("{} memory: rss {:.1f} MiB ({:+.1f} MiB), peak {:.1f} MiB, live allocations {:+}",
+                        test_case_name, memory_after.rss / 1048576.0,
+                        (static_cast<double>(memory_after.rss) - static_cast<double>(memory_before.rss)) / 1048576.0,
+                        memory_after.peak_rss / 1048576.0, leaked_allocations)
+                 << endl;
+            if (leaked_allocations > 0) { leaking_test_cases.emplace_back(test_case_index, leaked_allocations); }
+        }
+        if (rt == MINITEST_SUCCESS)
+        {
+            if (stats) { stats->record(test_case_name, false, false); }
+            if (history) { history->record(test_case_name, history_passed, duration); }
+            continue;
+        }
+        cout << format("{} failed", test_case_name) << endl;
+        auto passed = false;
+        for (unsigned retry = 1; retry <= options.retries && !passed; ++retry)
+        {
+            cout << format("Retrying {} ({}/{})", test_case_name, retry, options.retries) << endl;
+            passed = rerun_test_case(test_case_index) == MINITEST_SUCCESS;
+        }
+        (passed ? flaky_test_cases : failed_test_cases).push_back(test_case_index);
+        if (stats) { stats->record(test_case_name, true, passed); }
+        if (history) { history->record(test_case_name, passed ? history_flaky : history_failed, duration); }
+    }
+    cout << format("minitest: {} of {} test case{} passed.", order.size() - failed_test_cases.size(), order.size(),
+                order.size() > 1 ? "s" : "")
+         << endl;
+    for (auto test_case_index : flaky_test_cases)
+    {
+        cout << format("Flaky: {}", index.test_cases[test_case_index]->first) << endl;
+    }
+    for (auto test_case_index : failed_test_cases)
+    {
+        cout << format("Failed: {}", index.test_cases[test_case_index]->first) << endl;
+    }
+    for (auto [test_case_index, leaked_allocations] : leaking_test_cases)
+    {
+        cout << format("Leaking: {} ({} allocation{} not deallocated)", index.test_cases[test_case_index]->first,
+                    leaked_allocations, leaked_allocations > 1 ? "s" : "")
+             << endl;
+    }
+    if (history) { history->save(); }
+    if (impact) { impact->save(*options.impact_index); }
+    if (stats)
+    {
+        stats->save();
+        if (!flaky_test_cases.empty() || !failed_test_cases.empty())
+        {
+            cout << "minitest: flaky stats:" << endl;
+            for (auto test_case_index : flaky_test_cases) { stats->print(index.test_cases[test_case_index]->first); }
+            for (auto test_case_index : failed_test_cases) { stats->print(index.test_cases[test_case_index]->first); }
+        }
+    }
+    return failed_test_cases;
+}
+
+// Implement the flag_repeat flag. The test cases run quietly in the process, only the failures are reported.
+int repeat_test_cases(const vector<size_t> &order, const run_options &options)
+{
+    auto &index = get_test_case_index();
+    cout << format("minitest: repeating {} test case{} {}{}", order.size(), order.size() > 1 ? "s" : "",
+                options.repeat ? format("{} times", options.repeat) : "endlessly",
+                options.until_fail ? " until a failure" : "")
+         << endl;
+    uint64_t num_failures = 0;
+    auto start_time = chrono::steady_clock::now();
+    for (uint64_t iteration = 0; !options.repeat || iteration < options.repeat; ++iteration)
+    {
+        for (auto test_case_index : order)
+        {
+            if (run_test_case(pri_impl_run_nth_test_case, test_case_index) == MINITEST_SUCCESS) { continue; }
+            ++num_failures;
+            cout << format("{} failed in the iteration {}", index.test_cases[test_case_index]->first, iteration)
+                 << endl;
+            if (options.until_fail) { return MINITEST_FAILURE; }
+        }
+    }
+    cout << format("minitest: {} runs, {} failed, time elapsed: {}", options.repeat * order.size(), num_failures,
+                elapsed_time_str(chrono::steady_clock::now() - start_time))
+         << endl;
+    return num_failures ? MINITEST_FAILURE : MINITEST_SUCCESS;
+}
+
+#ifdef HAS_FORK
+// returns whether the test case fails when run after the predecessors, in a child process forked from this process
+bool fails_after(const vector<size_t> &predecessors, size_t test_case_index)
+{
+    return MINITEST_SUCCESS != wait_child(fork_child(
+                                   [&]
+                                   {
+                                       ::silent_mode = true;
+                                       for (auto predecessor : predecessors)
+                                       {
+                                           (void)run_test_case(pri_impl_run_nth_test_case, predecessor);
+                                       }
+                                       return run_test_case(pri_impl_run_nth_test_case, test_case_index);
+                                   },
+                                   true));
+}
+
+// Bisect the predecessors to find the minimal predecessors making the test case fail. The bisection stops when the
+// failure requires predecessors from both halves.
+vector<size_t> find_polluters(vector<size_t> candidates, size_t test_case_index)
+{
+    while (candidates.size() > 1)
+    {
+        auto middle = candidates.begin() + candidates.size() / 2;
+        vector<size_t> first(candidates.begin(), middle);
+        vector<size_t> second(middle, candidates.end());
+        if (fails_after(first, test_case_index)) { candidates = std::move(first); }
+        else if (fails_after(second, test_case_index)) { candidates = std::move(second); }
+        else { break; }
+    }
+    return candidates;
+}
+
+// Implement the flag_detect_order_deps flag. The test cases run in a child process, so this process stays a clean
+// snapshot to fork the bisection runs from.
+int detect_order_dependencies(const vector<size_t> &order, const run_options &options)
+{
+    int fds[2];
+    if (pipe(fds))
+    {
+        cout << format("minitest: pipe failed: {}", strerror(errno)) << endl;
+        return MINITEST_FAILURE;
+    }
+    auto pid = fork_child(
+        [&]
+        {
+            close(fds[0]);
+            auto failed_test_cases = run_test_cases_in_order(order, options);
+            auto data = reinterpret_cast<const char *>(failed_test_cases.data());
+            for (auto size = failed_test_cases.size() * sizeof(size_t); size;)
+            {
+                auto written = write(fds[1], data, size);
+                if (written <= 0) { break; }
+                data += written;
+                size -= written;
+            }
+            close(fds[1]);
+            return failed_test_cases.empty() ? MINITEST_SUCCESS : MINITEST_FAILURE;
+        },
+        false);
+    close(fds[1]);
+    vector<size_t> failed_test_cases;
+    size_t test_case_index;
+    // a short read never happens for a pipe unless the child crashes
+    while (read(fds[0], &test_case_index, sizeof(test_case_index)) == sizeof(test_case_index))
+    {
+        failed_test_cases.push_back(test_case_index);
+    }
+    close(fds[0]);
+    auto code = wait_child(pid);
+    if (code != MINITEST_SUCCESS && failed_test_cases.empty())
+    {
+        cout << "minitest: the test run crashed, no order dependency can be detected." << endl;
+        return MINITEST_FAILURE;
+    }
+
+    auto &index = get_test_case_index();
+    for (auto failed_test_case : failed_test_cases)
+    {
+        auto test_case_name = index.test_cases[failed_test_case]->first;
+        cout << format("minitest: detecting the order dependency of {}", test_case_name) << endl;
+        if (fails_after({}, failed_test_case))
+        {
+            cout << format("{} fails when run alone, it either fails regardless of the order or depends on the test "
+                           "cases which ran before it in the registry order.",
+                        test_case_name)
+                 << endl;
+            continue;
+        }
+        vector<size_t> predecessors(order.begin(), find(order.begin(), order.end(), failed_test_case));
+        if (!fails_after(predecessors, failed_test_case))
+        {
+            cout << format("{} passes when rerun after the same test cases, it may be flaky.", test_case_name) << endl;
+            continue;
+        }
+        cout << format("{} depends on the test order, it fails after:", test_case_name) << endl;
+        for (auto polluter : find_polluters(std::move(predecessors), failed_test_case))
+        {
+            cout << format("    {}", index.test_cases[polluter]->first) << endl;
+        }
+    }
+    return failed_test_cases.empty() ? MINITEST_SUCCESS : MINITEST_FAILURE;
+}
+#endif // HAS_FORK
+
+#ifdef __linux__
+// the CPUs in a list file of /sys, such as /sys/devices/system/node/node0/cpulist, empty if it can't be read
+vector<unsigned> read_cpu_list(const filesystem::path &file)
+{
+    string list;
+    getline(ifstream(file), list);
+    try
+    {
+        return parse_cpu_list(file.string(), list);
+    }
+    catch (const string &)
+    {
+        return {};
+    }
+}
+
+string cpu_list_str(const vector<unsigned> &cpus)
+{
+    string list;
+    for (auto cpu : cpus) { list += format("{}{}", list.empty() ? "" : ",", cpu); }
+    return list;
+}
+
+// keeps the first logical CPU of each physical core, so the SMT siblings don't share a core
+vector<unsigned> one_cpu_per_core(const vector<unsigned> &cpus)
+{
+    vector<unsigned> kept;
+    for (auto cpu : cpus)
+    {
+        auto siblings = read_cpu_list(format("/sys/devices/system/cpu/cpu{}/topology/thread_siblings_list", cpu));
+        if (none_of(siblings.begin(), siblings.end(),
+                [&](unsigned sibling) { return binary_search(kept.begin(), kept.end(), sibling); }))
+        {
+            kept.push_back(cpu);
+        }
+    }
+    return kept;
+}
+#endif // __linux__
+
+// Implement the flag_cpus, flag_numa_node and flag_isolate flags. The runner and the threads and processes it starts
+// run on the selected CPUs. Returns false if the test cases can't be placed as required.
+bool place_test_run(const run_options &options)
+{
+    if (options.cpus.empty() && !options.numa_node && !options.isolate) { return true; }
+#ifdef __linux__
+    auto cpus = options.cpus;
+    if (options.numa_node)
+    {
+        auto node_cpus = read_cpu_list(format("/sys/devices/system/node/node{}/cpulist", *options.numa_node));
+        if (*options.numa_node >= max_cpu_count || node_cpus.empty())
+        {
+            cout << format("minitest: the NUMA node {} doesn't exist or has no CPUs", *options.numa_node) << endl;
+            return false;
+        }
+        if (cpus.empty()) { cpus = std::move(node_cpus); }
+        else
+        {
+            vector<unsigned> common;
+            set_intersection(cpus.begin(), cpus.end(), node_cpus.begin(), node_cpus.end(), back_inserter(common));
+            cpus = std::move(common);
+            if (cpus.empty())
+            {
+                cout << format("minitest: none of the CPUs is on the NUMA node {}", *options.numa_node) << endl;
+                return false;
+            }
+        }
+        // MPOL_BIND of <numaif.h>, the memory is allocated on the node only
+        constexpr int mpol_bind = 2;
+        // the node mask is an array of unsigned long, 32 bits each on 32-bit targets, the kernel ignores the last bit
+        constexpr unsigned bits_per_word = numeric_limits<unsigned long>::digits;
+        vector<unsigned long> nodes(*options.numa_node / bits_per_word + 1);
+        nodes.back() = 1ul << (*options.numa_node % bits_per_word);
+        if (syscall(SYS_set_mempolicy, mpol_bind, nodes.data(), nodes.size() * bits_per_word + 1))
+        {
+            cout << format("minitest: failed to bind the memory to the NUMA node {}: {}", *options.numa_node,
+                        strerror(errno))
+                 << endl;
+            return false;
+        }
+    }
+    if (!cpus.empty())
+    {
+        cpus = one_cpu_per_core(cpus);
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (auto cpu : cpus) { CPU_SET(cpu, &cpu_set); }
+        if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set))
+        {
+            cout << format("minitest: failed to run on the CPUs {}: {}", cpu_list_str(cpus), strerror(errno)) << endl;
+            return false;
+        }
+        cout << format("minitest: running on the CPUs {}", cpu_list_str(cpus)) << endl;
+    }
+    if (options.isolate)
+    {
+        // both need privileges, the test cases still run without them
+        if (setpriority(PRIO_PROCESS, 0, -20))
+        {
+            cout << format("minitest: failed to raise the priority: {}", strerror(errno)) << endl;
+        }
+        if (mlockall(MCL_CURRENT | MCL_FUTURE))
+        {
+            cout << format("minitest: failed to lock the memory: {}", strerror(errno)) << endl;
+        }
+    }
+#else
+    cout << "minitest: CPU and NUMA placement is not supported on this platform." << endl;
+#endif // __linux__
+    return true;
+}
+
+// run the selected test cases one by one in the process
+int run_selected_test_cases(const test_case_set &selected_test_cases, const run_options &options)
+{
+    if (!place_test_run(options)) { return MINITEST_FAILURE; }
+    auto selected = selected_test_cases;
+    if (options.changed_files)
+    {
+        auto impacted = select_impacted_test_cases(selected, *options.impact_index, *options.changed_files);
+        if (!impacted) { return MINITEST_FAILURE; }
+        selected = std::move(*impacted);
+    }
+    else if (options.impact_index && !impact_recorder::instrumented())
+    {
+        cout << format("minitest: {} records the impact index only if the test program is built with "
+                       "-fsanitize-coverage=trace-pc-guard and defines MINITEST_RECORD_COVERAGE()",
+                    minitest::pri_impl::flag_impact_index)
+             << endl;
+        return MINITEST_FAILURE;
+    }
+    vector<size_t> order;
+    order.reserve(selected.count());
+    selected.for_each([&](size_t test_case_index) { order.push_back(test_case_index); });
+    if (options.shuffle_seed)
+    {
+        cout << format("minitest: shuffling the test cases with seed {}", *options.shuffle_seed) << endl;
+        shuffle_test_cases(order, *options.shuffle_seed);
+    }
+    if (options.detect_order_deps)
+    {
+#ifdef HAS_FORK
+        return detect_order_dependencies(order, options);
+#else
+        cout << "minitest: order dependency detection is not supported on this platform." << endl;
+#endif // HAS_FORK
+    }
+    if (options.repeat != 1 || options.until_fail) { return repeat_test_cases(order, options); }
+    return run_test_cases_in_order(order, options).empty() ? MINITEST_SUCCESS : MINITEST_FAILURE;
+}
+
+#ifdef HAS_UNIX_SOCKETS
+#ifdef MSG_NOSIGNAL
+constexpr int send_line_flags = MSG_NOSIGNAL;
+#else
+// SO_NOSIGPIPE is set on the sockets of the clients instead
+constexpr int send_line_flags = 0;
+#endif // MSG_NOSIGNAL
+
+// writes all of the line and a line break, without SIGPIPE if the client has disconnected
+bool send_line(int fd, string_view line)
+{
+    auto text = format("{}\n", line);
+    for (string_view rest = text; !rest.empty();)
+    {
+        auto written = send(fd, rest.data(), rest.size(), send_line_flags);
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written <= 0) { return false; }
+        rest.remove_prefix(written);
+    }
+    return true;
+}
+
+// Runs the test cases in a child forked from the warm process, and streams the results to the client:
+//   case <name>
+//   output <line>                          the output of the test case, line by line
+//   passed <name> <nanoseconds> | failed <name> <nanoseconds>
+//   done <passed> <selected>
+void serve_run_request(int fd, const string &name_or_filter)
+{
+    test_case_set selected;
+    // a name is tried first, a test case name may not be a valid filter
+    auto &index = get_test_case_index();
+    if (auto test_case_index = index.find(name_or_filter))
+    {
+        selected = test_case_set(index.test_cases.size());
+        selected.set(*test_case_index);
+    }
+    else
+    {
+        try
+        {
+            selected = select_test_cases(name_or_filter.c_str());
+        }
+        catch (const string &e)
+        {
+            // the error line ends the response, the rest of the message is sent as output lines before it
+            auto lines = split_lines(e);
+            for (size_t i = 1; i < lines.size(); ++i)
+            {
+                send_line(fd, format("output {}", lines[i].substr(0, lines[i].find('\n'))));
+            }
+            send_line(fd, format("error {}", lines.empty() ? "" : lines[0].substr(0, lines[0].find('\n'))));
+            return;
+        }
+    }
+    auto pid = fork_child(
+        [&]
+        {
+            ::silent_mode = true;
+            size_t passed = 0;
+            selected.for_each(
+                [&](size_t test_case_index)
+                {
+                    auto test_case_name = index.test_cases[test_case_index]->first;
+                    send_line(fd, format("case {}", test_case_name));
+                    ostringstream output;
+                    auto cout_buff = cout.rdbuf(output.rdbuf());
+                    auto start_time = chrono::steady_clock::now();
+                    auto rt = run_test_case(run_registered_test_case, test_case_name);
+                    auto duration = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_time);
+                    cout.rdbuf(cout_buff);
+                    for (auto line : split_lines(output.view()))
+                    {
+                        send_line(fd, format("output {}", line.substr(0, line.find('\n'))));
+                    }
+                    passed += rt == MINITEST_SUCCESS;
+                    send_line(fd, format("{} {} {}", rt == MINITEST_SUCCESS ? "passed" : "failed", test_case_name,
+                                      duration.count()));
+                });
+            send_line(fd, format("done {} {}", passed, selected.count()));
+            return MINITEST_SUCCESS;
+        },
+        false);
+    int status = 0;
+    while (pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    if (pid < 0) { send_line(fd, "error failed to fork the test run"); }
+    else if (WIFSIGNALED(status))
+    {
+        send_line(fd, format("error the test run was terminated by the signal {} ({})", WTERMSIG(status),
+                          strsignal(WTERMSIG(status))));
+    }
+    else if (!WIFEXITED(status) || WEXITSTATUS(status) != MINITEST_SUCCESS)
+    {
+        send_line(fd, "error the test run exited before it finished");
+    }
+}
+
+// Serves the requests of one client, returns false if it requests to quit.
+bool serve_client(int fd)
+{
+    string buffer;
+    char chunk[4096];
+    for (;;)
+    {
+        auto line_end = buffer.find('\n');
+        if (line_end == string::npos)
+        {
+            auto received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR) { continue; }
+            if (received <= 0) { return true; }
+            buffer.append(chunk, received);
+            continue;
+        }
+        auto request = buffer.substr(0, line_end);
+        buffer.erase(0, line_end + 1);
+        if (request.ends_with('\r')) { request.pop_back(); }
+
+        if (request == "list")
+        {
+            auto &index = get_test_case_index();
+            for (auto test_case : index.test_cases) { send_line(fd, format("test {}", test_case->first)); }
+            send_line(fd, format("done {}", index.test_cases.size()));
+        }
+        else if (request.starts_with("run ")) { serve_run_request(fd, request.substr(4)); }
+        else if (request == "quit")
+        {
+            send_line(fd, "bye");
+            return false;
+        }
+        else { send_line(fd, format("error unknown request: {}", request)); }
+    }
+}
+
+// Implement the flag_serve flag, serve the clients one by one until one of them requests to quit.
+int serve_test_cases(const filesystem::path &socket_path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    auto path = socket_path.string();
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        cout << format("minitest: invalid socket path for {}: {}", minitest::pri_impl::flag_serve, path) << endl;
+        return MINITEST_FAILURE;
+    }
+    path.copy(address.sun_path, path.size());
+    // SOCK_CLOEXEC and accept4 are not portable, the test cases must not inherit the sockets
+    auto server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0)
+    {
+        cout << format("minitest: failed to create a socket: {}", strerror(errno)) << endl;
+        return MINITEST_FAILURE;
+    }
+    fcntl(server_fd, F_SETFD, FD_CLOEXEC);
+    // a socket left by a server which didn't quit, any other file is kept
+    struct stat status;
+    if (!lstat(path.c_str(), &status))
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            cout << format("minitest: {} exists and is not a socket", path) << endl;
+            close(server_fd);
+            return MINITEST_FAILURE;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(server_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) || listen(server_fd, 8))
+    {
+        cout << format("minitest: failed to listen on {}: {}", path, strerror(errno)) << endl;
+        close(server_fd);
+        return MINITEST_FAILURE;
+    }
+    cout << format("minitest: serving {} test case{} on {}", get_test_case_index().test_cases.size(),
+                get_test_case_index().test_cases.size() > 1 ? "s" : "", path)
+         << endl;
+    for (bool serving = true; serving;)
+    {
+        auto client_fd = accept(server_fd, nullptr, nullptr);
+        if (client_fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+            cout << format("minitest: failed to accept a client: {}", strerror(errno)) << endl;
+            break;
+        }
+        fcntl(client_fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+        int no_sigpipe = 1;
+        setsockopt(client_fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif // SO_NOSIGPIPE
+        serving = serve_client(client_fd);
+        close(client_fd);
+    }
+    close(server_fd);
+    unlink(path.c_str());
+    return MINITEST_SUCCESS;
+}
+#endif // HAS_UNIX_SOCKETS
+
+// Implement the flag_pri_impl_discover_test_cases flag, only the selected test cases are added to CTest.
+auto discover_test_case(filesystem::path executable_path, const string &guid, filesystem::path test_config_file,
+    const test_case_set &selected)
+{
+    // read all the content of the test file
+    ifstream ifs(test_config_file);
+    if (!ifs)
+    {
+        cout << format("minitest discover test cases failed: failed to open file {}", test_config_file.string())
+             << endl;
+        return MINITEST_FAILURE;
+    }
+    string content((istreambuf_iterator<char>(ifs)), (istreambuf_iterator<char>()));
+    ifs.close();
+
+    const auto mark_line = format("# {}", guid);
+    // remove the old data
+    // remove the lines from the first mark line to the last mark line, the file is large with many test cases, so it's
+    // scanned without regular expressions
+    auto mark = mark_line + '\n';
+    if (auto first = content.find(mark); first != string::npos)
+    {
+        if (auto last = content.rfind(mark); last != first) { content.erase(first, last + mark.size() - first); }
+    }
+    // remove the lines contain **guid**
+    string kept;
+    kept.reserve(content.size());
+    for (size_t line_begin = 0; line_begin < content.size();)
+    {
+        auto line_end = content.find('\n', line_begin);
+        line_end = line_end == string::npos ? content.size() : line_end + 1;
+        auto line = string_view(content).substr(line_begin, line_end - line_begin);
+        if (!line.ends_with('\n') || line.find(guid) == string_view::npos) { kept += line; }
+        line_begin = line_end;
+    }
+    content = std::move(kept);
+
+    if (!selected.count())
+    {
+        cout << "minitest_discover_tests: no test cases found for " << executable_path << endl;
+    }
+    else
+    {
+        // append the new data
+        content += mark_line;
+        content += '\n';
+        auto &index = get_test_case_index();
+        selected.for_each([&](size_t test_case_index)
+        {
+            auto &[name, info] = *index.test_cases[test_case_index];
+            content += format(R"(add_test([====[{0}]====] "{1}" {2} "{3}"))", name, executable_path.generic_string(),
+                minitest::pri_impl::flag_pri_impl_run_nth_test_case, test_case_index);
+            content += '\n';
+            string location = info.test_case_location;
+            // replace the last ':' with ';' in the location
+            auto last_colon = location.find_last_of(':');
+            assert(last_colon != string::npos);
+            location[last_colon] = ';';
+            // replace the '\' with '/' in the location
+            replace(location.begin(), location.end(), '\\', '/');
+            content += format(
+                R"(set_tests_properties([====[{0}]====] PROPERTIES _BACKTRACE_TRIPLES "{1};minitest_discover_tests"))",
+                name, location);
+            content += '\n';
+        });
+        content += mark_line;
+        content += '\n';
+    }
+
+    ofstream ofs(test_config_file);
+    if (!ofs)
+    {
+        cout << format("minitest discover test cases failed: failed to open file {}", test_config_file.string())
+             << endl;
+        return MINITEST_FAILURE;
+    }
+    ofs << content;
+
+    return MINITEST_SUCCESS;
+}
+
+// The probes are never destroyed, they may be recorded by threads running at exit.
+struct probe_registry
+{
+    mutex mtx;
+    map<string, unique_ptr<minitest::pri_impl::counter_probe>, less<>> counters;
+    map<string, unique_ptr<minitest::pri_impl::histogram_probe>, less<>> histograms;
+    map<string, unique_ptr<minitest::pri_impl::histogram_probe>, less<>> timers;
+};
+
+probe_registry &get_probe_registry()
+{
+    static auto registry = new probe_registry;
+    return *registry;
+}
+
+template <class P> P &get_probe(map<string, unique_ptr<P>, less<>> &probes, const char *name)
+{
+    auto &registry = get_probe_registry();
+    lock_guard lock(registry.mtx);
+    auto it = probes.find(string_view(name));
+    if (it == probes.end()) { it = probes.emplace(name, make_unique<P>()).first; }
+    return *it->second;
+}
+
+void dump_histogram(ostream &os, string_view name, const minitest::pri_impl::histogram_probe &probe, string_view unit)
+{
+    using minitest::pri_impl::histogram_probe;
+    uint64_t buckets[histogram_probe::bucket_count];
+    uint64_t sum, max;
+    probe.merge(buckets, sum, max);
+    uint64_t count = 0;
+    for (auto bucket : buckets) { count += bucket; }
+    if (!count)
+    {
+        os << format("  {}: count 0", name) << endl;
+        return;
+    }
+    // the upper bound of the bucket of the percentile, capped by the max
+    auto percentile = [&](double p)
+    {
+        auto rank = static_cast<uint64_t>(ceil(p * static_cast<double>(count)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < histogram_probe::bucket_count; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank && buckets[i])
+            {
+                if (i + 1 == histogram_probe::bucket_count) { return max; }
+                return min(histogram_probe::bucket_lower_bound(i + 1) - 1, max);
+            }
+        }
+        return max;
+    };
+    os << format("  {0}: count {1}, mean {2:.1f}{3}, p50 {4}{3}, p90 {5}{3}, p99 {6}{3}, max {7}{3}", name, count,
+              static_cast<double>(sum) / static_cast<double>(count), unit, percentile(0.5), percentile(0.9),
+              percentile(0.99), max)
+       << endl;
+}
+// owns a spawned task, the coroutine frame is destroyed by the event loop
+struct spawned_task
+{
+    struct promise_type
+    {
+        spawned_task get_return_object() { return {coroutine_handle<promise_type>::from_promise(*this)}; }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        // unreachable, run_spawned_task catches all exceptions
+        void unhandled_exception() noexcept { terminate(); }
+    };
+
+    coroutine_handle<promise_type> handle;
+};
+
+// The demangled type names, read without locking. An entry is published to an empty slot of the open-addressing
+// table after its name is written, and is never removed. The entries and their names live in fixed arenas, the names
+// which don't fit are demangled on every call.
+class type_name_cache
+{
+  public:
+    // returns nullptr if the type isn't cached
+    const string_view *find(const type_info &type, size_t hash) const
+    {
+        for (auto slot = hash & slot_mask;; slot = (slot + 1) & slot_mask)
+        {
+            auto entry = slots[slot].load(memory_order_acquire);
+            if (!entry) { return nullptr; }
+            if (entry->hash == hash && (entry->type == &type || *entry->type == type)) { return &entry->name; }
+        }
+    }
+
+    // copies the name into the arena, returns nullptr if the cache is full
+    const string_view *insert(const type_info &type, size_t hash, string_view name)
+    {
+        lock_guard lock(insert_mutex);
+        if (auto cached = find(type, hash)) { return cached; }
+        if (entry_count == max_entries || name_bytes + name.size() > names.size()) { return nullptr; }
+        auto &entry = entries[entry_count++];
+        entry = {&type, hash, {names.data() + name_bytes, name.size()}};
+        name_bytes += name.copy(names.data() + name_bytes, name.size());
+        auto slot = hash & slot_mask;
+        while (slots[slot].load(memory_order_relaxed)) { slot = (slot + 1) & slot_mask; }
+        slots[slot].store(&entry, memory_order_release);
+        return &entry.name;
+    }
+
+  private:
+    struct entry_type
+    {
+        const type_info *type;
+        size_t hash;
+        string_view name;
+    };
+    // at most half of the slots are used, so a probe finds an empty slot soon
+    static constexpr size_t max_entries = 512;
+    static constexpr size_t slot_mask = 2 * max_entries - 1;
+
+    array<atomic<const entry_type *>, slot_mask + 1> slots{};
+    array<entry_type, max_entries> entries;
+    array<char, 256 * 1024> names;
+    size_t entry_count = 0;
+    size_t name_bytes = 0;
+    mutex insert_mutex;
+};
+
+string demangle(const type_info &type)
+{
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    unique_ptr<char, decltype(&free)> demangled(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &free);
+    if (status || !demangled) { return format("failed to demangle type name: {}, status: {}", type.name(), status); }
+    return demangled.get();
+#else
+    return type.name();
+#endif // __has_include(<cxxabi.h>)
+}
+
+thread_local minitest::event_loop *current_loop = nullptr;
+
+// the time of minitest::clock since its epoch
+atomic<minitest::clock::rep> virtual_clock_time{0};
+
+// sets the current event loop of the thread in the scope
+class current_loop_guard
+{
+  public:
+    explicit current_loop_guard(minitest::event_loop *loop) : previous_(exchange(current_loop, loop)) {}
+    current_loop_guard(const current_loop_guard &) = delete;
+    current_loop_guard &operator=(const current_loop_guard &) = delete;
+    ~current_loop_guard() { current_loop = previous_; }
+
+  private:
+    minitest::event_loop *previous_;
+};
+} // namespace
+
+#ifdef HAS_SANITIZER_HOOKS
+extern "C"
+{
+    // defined by the sanitizer runtimes when linked
+    __attribute__((weak)) void __sanitizer_set_death_callback(void (*callback)());
+    __attribute__((weak)) void __asan_set_error_report_callback(void (*callback)(const char *));
+
+    __attribute__((weak)) void __sanitizer_symbolize_pc(void *pc, const char *format, char *buffer, size_t size);
+}
+
+namespace
+{
+void install_sanitizer_hooks()
+{
+    static once_flag installed;
+    call_once(installed,
+        []
+        {
+            if (__asan_set_error_report_callback)
+            {
+                __asan_set_error_report_callback([](const char *) { attribute_sanitizer_report("AddressSanitizer"); });
+            }
+            if (__sanitizer_set_death_callback)
+            {
+                // the sanitizer doesn't recover, the process exits after the report
+                __sanitizer_set_death_callback(
+                    []
+                    {
+                        char message[512];
+                        auto test_case = running_test_case.load();
+                        auto size = snprintf(message, sizeof(message),
+                            "minitest: a sanitizer terminated the process in the test case: %s\n",
+                            test_case ? test_case : "<none>");
+                        (void)!write(STDERR_FILENO, message, min<size_t>(size, sizeof(message) - 1));
+                    });
+            }
+            sanitizer_hooks_installed = true;
+        });
+}
+
+unordered_map<uintptr_t, string> source_files(const vector<uintptr_t> &pcs)
+{
+    unordered_map<uintptr_t, string> files;
+    // the PCs left to addr2line and their addresses in the files of their modules, by module
+    map<string, vector<pair<uintptr_t, uintptr_t>>> module_addresses;
+    for (auto pc : pcs)
+    {
+        if (__sanitizer_symbolize_pc)
+        {
+            char file[4096] = {};
+            __sanitizer_symbolize_pc(reinterpret_cast<void *>(pc), "%s", file, sizeof(file));
+            if (*file && strcmp(file, "<null>"))
+            {
+                files.emplace(pc, normal_source_path(file));
+                continue;
+            }
+        }
+        Dl_info info;
+        if (!dladdr(reinterpret_cast<void *>(pc), &info) || !info.dli_fname || !info.dli_fbase) { continue; }
+        // the main program is reported by the name it was started with, which may be relative to another directory
+        error_code ec;
+        string module = strcmp(info.dli_fname, program_invocation_name) && *info.dli_fname
+                            ? info.dli_fname
+                            : filesystem::read_symlink("/proc/self/exe", ec).string();
+        // the addresses of position-independent modules are relative to their load address, the PC is a return address
+        auto base = static_cast<const ElfW(Ehdr) *>(info.dli_fbase)->e_type == ET_DYN
+                        ? reinterpret_cast<uintptr_t>(info.dli_fbase)
+                        : 0;
+        module_addresses[module].emplace_back(pc, pc - base - 1);
+    }
+    for (auto &[module, addresses] : module_addresses)
+    {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC)) { continue; }
+        auto address_file = filesystem::temp_directory_path() / format("minitest_impact_{}.txt", getpid());
+        {
+            ofstream ofs(address_file);
+            for (auto [pc, address] : addresses) { ofs << format("{:#x}\n", address); }
+        }
+        // addr2line prints `file:line` or `??:?` for each address, it's spawned without a shell
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, address_file.c_str(), O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+        char *argv[] = {const_cast<char *>("addr2line"), const_cast<char *>("-e"), const_cast<char *>(module.c_str()),
+            nullptr};
+        pid_t pid = -1;
+        auto spawned = !posix_spawnp(&pid, "addr2line", &actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[1]);
+        if (auto output = fdopen(fds[0], "r"))
+        {
+            char line[4096];
+            for (size_t i = 0; spawned && i < addresses.size() && fgets(line, sizeof(line), output); ++i)
+            {
+                string_view location(line);
+                location = location.substr(0, location.find(" (discriminator"));
+                location = location.substr(0, location.rfind(':'));
+                if (!location.empty() && location != "??")
+                {
+                    files.emplace(addresses[i].first, normal_source_path(location));
+                }
+            }
+            fclose(output);
+        }
+        else { close(fds[0]); }
+        while (spawned && waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+        error_code ec;
+        filesystem::remove(address_file, ec);
+    }
+    return files;
+}
+} // namespace
+#endif // HAS_SANITIZER_HOOKS
+
+struct minitest::event_loop::impl
+{
+    template <class Clock> struct timer
+    {
+        typename Clock::time_point when;
+        // the timers with the same time point fire in the order they were added
+        uint64_t sequence;
+        coroutine_handle<> handle;
+
+        bool operator>(const timer &other) const
+        {
+            return when != other.when ? when > other.when : sequence > other.sequence;
+        }
+    };
+
+    template <class Clock> using timer_queue = priority_queue<timer<Clock>, vector<timer<Clock>>, greater<>>;
+
+    deque<coroutine_handle<>> ready;
+    timer_queue<chrono::steady_clock> timers;
+    timer_queue<minitest::clock> virtual_timers;
+    uint64_t timer_sequence = 0;
+    vector<coroutine_handle<>> idle_waiters;
+    vector<coroutine_handle<spawned_task::promise_type>> spawned;
+    // the first exception thrown by a spawned task
+    exception_ptr exception;
+    // the readers and writers waiting for the fds
+    map<int, pair<coroutine_handle<>, coroutine_handle<>>> fd_waiters;
+#ifdef HAS_EPOLL
+    int epoll_fd = -1;
+#endif // HAS_EPOLL
+
+    // move the expired timers to the ready queue, returns whether any expired
+    template <class Clock> bool fire_timers(timer_queue<Clock> &queue)
+    {
+        auto now = Clock::now();
+        bool fired = false;
+        while (!queue.empty() && queue.top().when <= now)
+        {
+            ready.push_back(queue.top().handle);
+            queue.pop();
+            fired = true;
+        }
+        return fired;
+    }
+
+    // block until a timer expires or a fd is ready
+    void wait_for_events()
+    {
+        optional<chrono::steady_clock::time_point> deadline;
+        if (!timers.empty()) { deadline = timers.top().when; }
+#ifdef HAS_EPOLL
+        if (!fd_waiters.empty())
+        {
+            int timeout = -1;
+            if (deadline)
+            {
+                auto remaining = chrono::ceil<chrono::milliseconds>(*deadline - chrono::steady_clock::now()).count();
+                timeout = static_cast<int>(clamp<decltype(remaining)>(remaining, 0, INT32_MAX));
+            }
+            epoll_event events[64];
+            auto n = epoll_wait(epoll_fd, events, 64, timeout);
+            for (int i = 0; i < n; ++i)
+            {
+                auto fd = events[i].data.fd;
+                auto &[reader, writer] = fd_waiters[fd];
+                if (reader && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                {
+                    ready.push_back(exchange(reader, nullptr));
+                }
+                if (writer && (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+                {
+                    ready.push_back(exchange(writer, nullptr));
+                }
+                update_fd(fd);
+            }
+            return;
+        }
+#endif // HAS_EPOLL
+        if (deadline) { this_thread::sleep_until(*deadline); }
+    }
+
+#ifdef HAS_EPOLL
+    // sync the epoll registration of the fd with its waiters
+    void update_fd(int fd)
+    {
+        auto it = fd_waiters.find(fd);
+        if (it == fd_waiters.end()) { return; }
+        auto &[reader, writer] = it->second;
+        if (!reader && !writer)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            fd_waiters.erase(it);
+            return;
+        }
+        epoll_event event{};
+        event.events = (reader ? uint32_t{EPOLLIN} : 0) | (writer ? uint32_t{EPOLLOUT} : 0);
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) && errno == ENOENT)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+#endif // HAS_EPOLL
+};
+
+namespace
+{
+spawned_task run_spawned_task(minitest::task<> t, minitest::event_loop::impl &loop)
+{
+    try
+    {
+        co_await t;
+    }
+    catch (...)
+    {
+        if (!loop.exception) { loop.exception = current_exception(); }
+    }
+}
+} // namespace
+
+minitest::event_loop::event_loop() : impl_(make_unique<impl>())
+{
+#ifdef HAS_EPOLL
+    impl_->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#endif // HAS_EPOLL
+}
+
+minitest::event_loop::~event_loop()
+{
+    for (auto handle : impl_->spawned) { handle.destroy(); }
+#ifdef HAS_EPOLL
+    if (impl_->epoll_fd >= 0) { close(impl_->epoll_fd); }
+#endif // HAS_EPOLL
+}
+
+minitest::event_loop *minitest::event_loop::current() noexcept { return current_loop; }
+
+void minitest::event_loop::spawn(task<> t)
+{
+    auto spawned = run_spawned_task(std::move(t), *impl_);
+    impl_->spawned.push_back(spawned.handle);
+    impl_->ready.push_back(spawned.handle);
+}
+
+void minitest::event_loop::post(std::coroutine_handle<> handle) { impl_->ready.push_back(handle); }
+
+void minitest::event_loop::add_timer(std::chrono::steady_clock::time_point when, std::coroutine_handle<> handle)
+{
+    impl_->timers.push({when, impl_->timer_sequence++, handle});
+}
+
+void minitest::event_loop::add_timer(clock::time_point when, std::coroutine_handle<> handle)
+{
+    impl_->virtual_timers.push({when, impl_->timer_sequence++, handle});
+}
+
+void minitest::event_loop::add_idle_waiter(std::coroutine_handle<> handle) { impl_->idle_waiters.push_back(handle); }
+
+void minitest::event_loop::add_fd_waiter(int fd, bool writable, std::coroutine_handle<> handle)
+{
+#ifdef HAS_EPOLL
+    auto &[reader, writer] = impl_->fd_waiters[fd];
+    auto &waiter = writable ? writer : reader;
+    if (waiter)
+    {
+        cout << format("Error: another task is already waiting for the fd {} to be {}", fd,
+                    writable ? "writable" : "readable")
+             << endl;
+        throw minitest::minitest_assertion_failure{};
+    }
+    waiter = handle;
+    impl_->update_fd(fd);
+#else
+    (void)fd;
+    (void)writable;
+    (void)handle;
+    cout << "Error: waiting for fds is not supported on this platform" << endl;
+    throw minitest::minitest_assertion_failure{};
+#endif // HAS_EPOLL
+}
+
+void minitest::event_loop::run_until_done(std::coroutine_handle<> handle)
+{
+    current_loop_guard guard(this);
+    auto &loop = *impl_;
+    loop.ready.push_back(handle);
+    while (!handle.done())
+    {
+        if (loop.exception) { rethrow_exception(exchange(loop.exception, nullptr)); }
+        if (!loop.ready.empty())
+        {
+            auto next = loop.ready.front();
+            loop.ready.pop_front();
+            next.resume();
+            continue;
+        }
+        // fire both kinds of timers
+        if (loop.fire_timers(loop.timers) | loop.fire_timers(loop.virtual_timers)) { continue; }
+        if (!loop.idle_waiters.empty())
+        {
+            loop.ready.insert(loop.ready.end(), loop.idle_waiters.begin(), loop.idle_waiters.end());
+            loop.idle_waiters.clear();
+            continue;
+        }
+        if (loop.timers.empty() && loop.fd_waiters.empty())
+        {
+            // nothing but the virtual time can wake the tasks up
+            if (!loop.virtual_timers.empty())
+            {
+                minitest::clock::advance(loop.virtual_timers.top().when - minitest::clock::now());
+                continue;
+            }
+            cout << "Error: the task can never complete, all tasks are blocked" << endl;
+            throw minitest::minitest_assertion_failure{};
+        }
+        loop.wait_for_events();
+    }
+    if (loop.exception) { rethrow_exception(exchange(loop.exception, nullptr)); }
+    // release the completed spawned tasks
+    erase_if(loop.spawned,
+        [](auto spawned)
+        {
+            if (!spawned.done()) { return false; }
+            spawned.destroy();
+            return true;
+        });
+}
+
+minitest::clock::time_point minitest::clock::now() noexcept
+{
+    return time_point(duration(virtual_clock_time.load(memory_order_acquire)));
+}
+
+void minitest::clock::advance(duration d) noexcept
+{
+    if (d > duration::zero()) { virtual_clock_time.fetch_add(d.count(), memory_order_acq_rel); }
+}
+
+minitest::event_loop &minitest::pri_impl::current_event_loop()
+{
+    if (!current_loop)
+    {
+        cout << "Error: the awaitable must be awaited on an event loop, e.g. in an async test case" << endl;
+        throw minitest::minitest_assertion_failure{};
+    }
+    return *current_loop;
+}
+
+size_t minitest::pri_impl::next_probe_shard()
+{
+    static atomic<size_t> next_shard{0};
+    return next_shard.fetch_add(1, memory_order_relaxed) % probe_shard_count;
+}
+
+minitest::pri_impl::counter_probe &minitest::pri_impl::get_counter_probe(const char *name)
+{
+    return get_probe(get_probe_registry().counters, name);
+}
+
+minitest::pri_impl::histogram_probe &minitest::pri_impl::get_histogram_probe(const char *name)
+{
+    return get_probe(get_probe_registry().histograms, name);
+}
+
+minitest::pri_impl::histogram_probe &minitest::pri_impl::get_timer_probe(const char *name)
+{
+    return get_probe(get_probe_registry().timers, name);
+}
+
+uint64_t minitest::counter_value(const char *name)
+{
+    auto &registry = get_probe_registry();
+    lock_guard lock(registry.mtx);
+    auto it = registry.counters.find(string_view(name));
+    return it == registry.counters.end() ? 0 : it->second->value();
+}
+
+void minitest::reset_probes()
+{
+    auto &registry = get_probe_registry();
+    lock_guard lock(registry.mtx);
+    for (auto &[name, probe] : registry.counters) { probe->reset(); }
+    for (auto &[name, probe] : registry.histograms) { probe->reset(); }
+    for (auto &[name, probe] : registry.timers) { probe->reset(); }
+}
+
+void minitest::dump_probes(std::ostream &os)
+{
+    auto &registry = get_probe_registry();
+    lock_guard lock(registry.mtx);
+    os << "minitest: probes" << endl;
+    for (auto &[name, probe] : registry.counters) { os << format("  {}: {}", name, probe->value()) << endl; }
+    for (auto &[name, probe] : registry.histograms) { dump_histogram(os, name, *probe, ""); }
+    for (auto &[name, probe] : registry.timers) { dump_histogram(os, name, *probe, "ns"); }
+}
+
+minitest::memory_usage minitest::get_memory_usage()
+{
+    memory_usage usage;
+    usage.live_allocations = live_allocations.load(memory_order_relaxed);
+    tracking_peak_rss.store(true, memory_order_relaxed);
+#ifdef __linux__
+    if (ifstream statm("/proc/self/statm"); statm)
+    {
+        size_t size = 0;
+        size_t resident = 0;
+        statm >> size >> resident;
+        usage.rss = resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    // the peak since the last reset
+    ifstream status("/proc/self/status");
+    for (string line; getline(status, line);)
+    {
+        if (line.starts_with("VmHWM:"))
+        {
+            usage.peak_rss = stoull(line.substr(6)) * 1024;
+            return usage;
+        }
+    }
+#endif // __linux__
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        usage.rss = counters.WorkingSetSize;
+        usage.peak_rss = counters.PeakWorkingSetSize;
+    }
+#elif defined(HAS_FORK)
+    rusage resource_usage;
+    if (!getrusage(RUSAGE_SELF, &resource_usage))
+    {
+        // kilobytes, except bytes on Apple platforms
+#ifdef __APPLE__
+        usage.peak_rss = resource_usage.ru_maxrss;
+#else
+        usage.peak_rss = static_cast<size_t>(resource_usage.ru_maxrss) * 1024;
+#endif // __APPLE__
+    }
+#endif // _WIN32
+    return usage;
+}
+
+void *minitest::pri_impl::counted_allocate(std::size_t size)
+{
+    auto p = malloc(size ? size : 1);
+    if (!p) { throw bad_alloc{}; }
+    live_allocations.fetch_add(1, memory_order_relaxed);
+    return p;
+}
+
+void minitest::pri_impl::counted_deallocate(void *p) noexcept
+{
+    if (!p) { return; }
+    live_allocations.fetch_sub(1, memory_order_relaxed);
+    free(p);
+}
+
+// called when an instrumented module is loaded
+void minitest::pri_impl::on_sanitizer_report(const char *sanitizer) noexcept
+{
+#ifdef HAS_SANITIZER_HOOKS
+    attribute_sanitizer_report(sanitizer);
+#else
+    (void)sanitizer;
+#endif // HAS_SANITIZER_HOOKS
+}
+
+PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE void minitest::pri_impl::coverage_guard_init(
+    std::uint32_t *start, std::uint32_t *stop)
+{
+    auto &sections = coverage_guard_sections();
+    if (start == stop || find(sections.begin(), sections.end(), pair{start, stop}) != sections.end()) { return; }
+    sections.emplace_back(start, stop);
+    fill(start, stop, 0);
+}
+
+PRI_IMPL_MINITEST_NO_SANITIZE_COVERAGE void minitest::pri_impl::coverage_guard_hit(std::uintptr_t pc) noexcept
+{
+    auto hit = coverage_hit_count.fetch_add(1, memory_order_relaxed);
+    if (hit < coverage_hit_capacity) { coverage_hits[hit] = pc; }
+}
+
+std::string_view minitest::pri_impl::get_type_name(const std::type_info &type)
+{
+    static type_name_cache cache;
+    thread_local string uncached_name;
+    auto hash = type.hash_code();
+    if (auto cached = cache.find(type, hash)) { return *cached; }
+    uncached_name = demangle(type);
+    if (auto cached = cache.insert(type, hash, uncached_name)) { return *cached; }
+    return uncached_name;
+}
+
+void minitest::pri_impl::signal_expectation_failure() { expectation_failed = true; }
+
+void minitest::pri_impl::message_arg::print(std::ostream &os) const
+{
+    switch (kind_)
+    {
+    case kind::c_string: os << c_string_; break;
+    case kind::null: os << nullptr; break;
+    case kind::pointer: os << pointer_; break;
+    case kind::boolean: os << boolean_; break;
+    case kind::character: os << character_; break;
+    case kind::type: os << get_type_name(*type_); break;
+    case kind::signed_integer: os << signed_integer_; break;
+    case kind::unsigned_integer: os << unsigned_integer_; break;
+    case kind::floating_point: os << floating_point_; break;
+    case kind::string: os << string_view(string_.data, string_.size); break;
+    case kind::custom: custom_.print(os, custom_.object); break;
+    }
+}
+
+void minitest::pri_impl::print_message(
+    initializer_list<message_arg> message, const char *location, initializer_list<message_arg> custom_message)
+{
+#ifdef _WIN32
+    if (!silent_mode()) { win32_allocate_console(); }
+#endif // _WIN32
+    osyncstream o(cout);
+    for (auto &arg : message) { arg.print(o); }
+    o << endl;
+    if (custom_message.size())
+    {
+        o << "Custom message: ";
+        for (auto &arg : custom_message) { arg.print(o); }
+        o << endl;
+    }
+    o << location << "\n\n";
+}
+
+void minitest::pri_impl::print_info(initializer_list<message_arg> message)
+{
+#ifdef _WIN32
+    if (!silent_mode()) { win32_allocate_console(); }
+#endif // _WIN32
+    if (!message.size()) { return; }
+    osyncstream o(cout);
+    for (auto &arg : message) { arg.print(o); }
+    o << '\n';
+}
+
+void minitest::set_death_test_timeout(double seconds) { death_test_timeout = chrono::duration<double>(seconds); }
+
+minitest::death_test_status minitest::pri_impl::run_death_test(
+    death_test_statement_type statement, void *context, std::string &stderr_output)
+{
+#ifdef HAS_FORK
+    return run_death_test_child(statement, context, stderr_output);
+#else
+    (void)statement;
+    (void)context;
+    (void)stderr_output;
+    return {};
+#endif // HAS_FORK
+}
+
+bool minitest::pri_impl::match_death_test_output(const std::string &stderr_output, const char *regex)
+{
+    return regex_search(stderr_output, std::regex(regex));
+}
+
+std::string minitest::pri_impl::match_snapshot(const char *location, const char *name, std::string_view content)
+{
+    // the location is in the form of `file:line`
+    string_view source_file(location);
+    source_file = source_file.substr(0, source_file.rfind(':'));
+    auto file = filesystem::path(source_file).parent_path() / "snapshots" / name;
+    {
+        file_view snapshot(file);
+        auto expected = string_view(snapshot.data(), snapshot.size());
+        auto exists = !expected.empty() || filesystem::exists(file);
+        if (exists && expected == content) { return {}; }
+        if (!updating_snapshots)
+        {
+            if (!exists)
+            {
+                return format("The snapshot {} doesn't exist, run with {} to create it.", file.string(),
+                    flag_update_snapshots);
+            }
+            return diff_snapshot(file, expected, content);
+        }
+    }
+    return update_snapshot(file, content);
+}
+
+std::string minitest::pri_impl::describe_death_test(const death_test_status &status, const std::string &stderr_output)
+{
+    string description;
+    if (status.timed_out)
+    {
+        description = format("The statement didn't terminate the process in {} seconds.", death_test_timeout.count());
+    }
+    else if (status.returned) { description = "The statement returned instead of terminating the process."; }
+    else if (status.threw) { description = "The statement threw an exception instead of terminating the process."; }
+    else if (status.exited) { description = format("The process exited with the code {}.", status.exit_code); }
+    else if (status.signaled)
+    {
+#ifdef HAS_FORK
+        description = format("The process was terminated by the signal {} ({}).", status.signal, strsignal(status.signal));
+#endif // HAS_FORK
+    }
+    else { description = "Death tests are not supported on this platform."; }
+    if (stderr_output.empty()) { return description + " Nothing was written to stderr."; }
+    return format("{} The stderr output:\n{}", description, stderr_output);
+}
+
+int minitest::pri_impl::run_test(int argc, const char *const *argv)
+{
+    auto rt = try_run_test(argc, argv);
+    if (rt == PRI_IMPL_MINITEST_NOT_TEST_RUN) { throw minitest_do_nothing{}; }
+    return rt;
+}
+
+int minitest::pri_impl::try_run_test(int argc, const char *const *argv)
+{
+    auto &registered_test_cases = get_registered_test_cases();
+
+    if (argc < 1 || !argv || !argv[0])
+    {
+        cout << "minitest: failed to run test, invalid arguments." << endl;
+        return MINITEST_FAILURE;
+    }
+    updating_snapshots = find_flag_option(argc, argv, flag_update_snapshots).has_value();
+
+    if (find_flag_option(argc, argv, flag_history_report))
+    {
+        WIN32_ALLOCATE_CONSOLE();
+        auto file = find_flag_option(argc, argv, flag_history);
+        if (!file || file->empty())
+        {
+            cout << format("minitest: {} requires {}=<file>", flag_history_report, flag_history) << endl;
+            return MINITEST_FAILURE;
+        }
+        return report_history(*file);
+    }
+
+    for (int i = 1; i < argc; ++i)
     {
         if ("--minitest-help"sv == argv[i])
         {
@@ -288,10 +3186,72 @@ Usage:
     Run the specified test case in non-silent mode.
 {} <n>
     Run the nth test case in non-silent mode.
+
+In-process runner:
+{} <filter>
+    Run the test cases selected by the filter one by one in non-silent mode. If used with
+    {}, list the selected test cases instead. The filter is an expression of
+    test case name globs and [tag]s, combined with &&, ||, ! and parentheses.
+    For example: "[fast] && ![io]", "parser.* || [parser]", "!slow_*".
+{}[=seed]
+    Run the test cases in a random order. The seed is printed so the order can be reproduced.
+{}
+    If a test case fails, find the test cases which make it fail by running them before it in
+    child processes forked from a clean process. Not supported on Windows.
+{}=<n>
+    Rerun a failed test case up to n times, in a child process if supported. A test case which
+    passes on a retry is reported as flaky.
+{}=<file>
+    Record the pass/fail history of the test cases in the file, and print the failure rate
+    estimates of the failed and flaky test cases.
+{}=<n>
+    Run the test cases n times (0 for no limit), only the failures are reported.
+{}
+    Stop repeating at the first failure, repeat without a limit if the number of runs is not set.
+{}
+    Print the counters, histograms and timers recorded by the probes after the test cases ran.
+{}=<file>
+    Append the results and durations of the test cases to the history file.
+{}
+    Print the RSS, the peak RSS and the live allocations after each test case, and list the test
+    cases which leave more live allocations. The allocations are counted with
+    MINITEST_COUNT_ALLOCATIONS().
+{}
+    Write the snapshots compared by ASSERT_MATCHES_SNAPSHOT and EXPECT_MATCHES_SNAPSHOT instead of
+    comparing them.
+{}=<list>
+    Run on the CPUs in the list, e.g. 0-3,8, using one logical CPU of each physical core.
+{}=<n>
+    Run on the CPUs of the NUMA node n and allocate the memory on it.
+{}
+    Raise the priority of the process and lock its memory, this requires privileges.
+{}=<file>
+    Record the source files executed by each test case in the impact index. The test program must
+    be built with -fsanitize-coverage=trace-pc-guard and define MINITEST_RECORD_COVERAGE().
+{}=<list> {}=<file>
+    Run only the test cases which executed any of the changed files in the comma-separated list,
+    and the test cases which aren't in the impact index.
+Any of the flags above runs all the test cases one by one in the process in non-silent mode, or
+the test cases selected by {} if specified.
+
+{}=<unix-socket>
+    Stay resident and serve the requests of the clients on the socket, one per line: `list`,
+    `run <test case name or filter>` and `quit`. Each run is forked from the resident process.
+
+{} {}=<file>
+    Print the duration percentiles of the test cases recorded in the history file, and fail if
+    the median duration of the last {} runs of a test case is more than {}% and {}ms above the
+    median of the runs before them.
             )",
                         filesystem::path(argv[0]).filename().string(), registered_test_cases.size(),
                         registered_test_cases.size() > 1 ? "s" : "", flag_list_test_cases, flag_run_test_case,
-                        flag_run_nth_test_case)
+                        flag_run_nth_test_case, flag_filter, flag_list_test_cases, flag_shuffle,
+                        flag_detect_order_deps, flag_retries, flag_flaky_stats, flag_repeat, flag_until_fail,
+                        flag_dump_probes, flag_history, flag_check_memory, flag_update_snapshots, flag_cpus,
+                        flag_numa_node, flag_isolate, flag_impact_index, flag_changed_files, flag_impact_index,
+                        flag_filter, flag_serve, flag_history_report, flag_history,
+                        history_drift_window, (history_drift_ratio - 1) * 100,
+                        history_drift_min_ns / 1e6)
                  << endl;
             return MINITEST_SUCCESS;
         }
@@ -299,11 +3259,16 @@ Usage:
         if (!strcmp(argv[i], flag_list_test_cases))
         {
             WIN32_ALLOCATE_CONSOLE();
-            cout << format("minitest: {0} has {1} test case{2}.", filesystem::path(argv[0]).filename().string(),
-                        registered_test_cases.size(), registered_test_cases.size() > 1 ? "s" : "")
-                 << endl;
-            list_registered_test_cases();
-            return MINITEST_SUCCESS;
+            return with_selected_test_cases(find_flag_value(argc, argv, flag_filter),
+                [&](const test_case_set &selected)
+                {
+                    cout << format("minitest: {0} has {1} test case{2}.",
+                                filesystem::path(argv[0]).filename().string(), registered_test_cases.size(),
+                                registered_test_cases.size() > 1 ? "s" : "")
+                         << endl;
+                    list_registered_test_cases(selected);
+                    return MINITEST_SUCCESS;
+                });
         }
         else if (!strcmp(argv[i], flag_run_test_case) && i + 1 < argc)
         {
@@ -320,15 +3285,63 @@ Usage:
         }
         else if (!strcmp(argv[i], flag_pri_impl_discover_test_cases) && i + 2 < argc)
         {
-            return discover_test_case(filesystem::absolute(argv[0]), argv[i + 1], filesystem::path(argv[i + 2]));
+            // the optional third argument is a filter
+            return with_selected_test_cases(i + 3 < argc ? argv[i + 3] : nullptr,
+                [&](const test_case_set &selected)
+                {
+                    return discover_test_case(
+                        filesystem::absolute(argv[0]), argv[i + 1], filesystem::path(argv[i + 2]), selected);
+                });
+        }
+        else if (auto socket_path = parse_flag_option(argv[i], flag_serve))
+        {
+            if (socket_path->empty())
+            {
+                cout << format("minitest: {} requires a socket path", flag_serve) << endl;
+                return MINITEST_FAILURE;
+            }
+#ifdef HAS_UNIX_SOCKETS
+            return serve_test_cases(*socket_path);
+#else
+            cout << format("minitest: {} is not supported on this platform.", flag_serve) << endl;
+            return MINITEST_FAILURE;
+#endif // HAS_UNIX_SOCKETS
+        }
+        else if ((!strcmp(argv[i], flag_filter) && i + 1 < argc) || is_run_option(argv[i]))
+        {
+            WIN32_ALLOCATE_CONSOLE();
+            run_options options;
+            try
+            {
+                options = parse_run_options(argc, argv);
+            }
+            catch (const string &e)
+            {
+                cout << e << endl;
+                return MINITEST_FAILURE;
+            }
+            return with_selected_test_cases(find_flag_value(argc, argv, flag_filter),
+                [&](const test_case_set &selected)
+                {
+                    auto rt = run_selected_test_cases(selected, options);
+                    if (options.dump_probes) { minitest::dump_probes(cout); }
+                    return rt;
+                });
         }
     }
 
-    throw minitest_do_nothing{};
+    return PRI_IMPL_MINITEST_NOT_TEST_RUN;
+}
+
+void minitest::pri_impl::abort_test_case()
+{
+    if (abort_point) { longjmp(*abort_point, 1); }
+    cout << "Error: an assertion failed outside of a test case, abort." << endl;
+    abort();
 }
 
-minitest::pri_impl::auto_reg_test_case::auto_reg_test_case(
-    const char *test_case_name, test_case_function_type test_case_func, const char *test_case_location)
+minitest::pri_impl::auto_reg_test_case::auto_reg_test_case(const char *test_case_name,
+    test_case_function_type test_case_func, const char *test_case_location, initializer_list<const char *> test_case_tags)
 try
 {
     if (!test_case_name || string_view(test_case_name).empty())
@@ -341,7 +3354,16 @@ try
         throw format("{} has been registered at\n{}, failed to register at\n{}.", test_case_name,
             registered_test_cases[test_case_name].test_case_location, test_case_location);
     }
-    registered_test_cases[test_case_name] = {test_case_func, test_case_location};
+    for (auto tag : test_case_tags)
+    {
+        if (!tag || !*tag || strpbrk(tag, "[]"))
+        {
+            throw format("the tags of {} should not be empty or contain '[' or ']'.{}", test_case_name,
+                test_case_location);
+        }
+    }
+    registered_test_cases[test_case_name] = {
+        test_case_func, test_case_location, vector<string_view>(test_case_tags.begin(), test_case_tags.end())};
 }
 catch (const string &e)
 {
@@ -350,6 +3372,64 @@ catch (const string &e)
     exit(MINITEST_FAILURE);
 }
 
+minitest::pri_impl::auto_reg_fixture::auto_reg_fixture(const type_info &fixture_type, fixture_scope scope,
+    fixture_factory_type fixture_factory, fixture_deleter_type fixture_deleter, const char *fixture_location)
+try
+{
+    auto &registry = get_fixture_registry();
+    lock_guard lock(registry.mutex);
+    auto [it, inserted] = registry.fixtures.try_emplace(fixture_type);
+    if (!inserted)
+    {
+        throw format("{} has been registered at\n{}, failed to register at\n{}.", get_type_name(fixture_type),
+            it->second.fixture_location, fixture_location);
+    }
+    it->second.scope = scope;
+    it->second.fixture_factory = fixture_factory;
+    it->second.fixture_deleter = fixture_deleter;
+    it->second.fixture_location = fixture_location;
+}
+catch (const string &e)
+{
+    cout << "minitest: failed to register fixture." << endl;
+    cout << e << endl;
+    exit(MINITEST_FAILURE);
+}
+
+const void *minitest::pri_impl::get_fixture(const type_info &fixture_type)
+{
+    auto &registry = get_fixture_registry();
+    // the fixtures are only registered before main(), no lock is required to find them
+    auto it = registry.fixtures.find(fixture_type);
+    if (it == registry.fixtures.end())
+    {
+        cout << format("Error: the fixture {} is not registered", get_type_name(fixture_type)) << endl;
+        throw minitest::minitest_assertion_failure{};
+    }
+    auto &info = it->second;
+    if (auto fixture = info.fixture.load(memory_order_acquire)) { return fixture; }
+
+    lock_guard lock(registry.mutex);
+    if (auto fixture = info.fixture.load(memory_order_relaxed)) { return fixture; }
+    auto start_time = chrono::steady_clock::now();
+    ++registry.building_depth;
+    void *fixture = nullptr;
+    try
+    {
+        fixture = info.fixture_factory();
+    }
+    catch (...)
+    {
+        --registry.building_depth;
+        throw;
+    }
+    // only the outermost fixture is timed, the fixtures it uses are included
+    if (!--registry.building_depth) { registry.setup_time += chrono::steady_clock::now() - start_time; }
+    registry.built_fixtures.push_back(&info);
+    info.fixture.store(fixture, memory_order_release);
+    return fixture;
+}
+
 bool minitest::silent_mode() { return ::silent_mode; }
 
 #ifdef _WIN32
@@ -373,7 +3453,7 @@ int minitest::pri_impl::win32_run_test()
         ASSERT_TRUE(len == len1);
     }
     LocalFree(argv_w);
-    return minitest::pri_impl::run_test(argc, argv.get());
+    return minitest::pri_impl::try_run_test(argc, argv.get());
 }
 
 void minitest::pri_impl::win32_allocate_console()
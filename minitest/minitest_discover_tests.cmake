@@ -1,4 +1,7 @@
+# minitest_discover_tests(target [FILTER filter])
+#   FILTER: only the test cases selected by the filter are added to CTest, see `--minitest-filter`
 function(minitest_discover_tests target)
+    cmake_parse_arguments(PARSE_ARGV 1 arg "" "FILTER" "")
     get_target_property(target_type ${target} TYPE)
     get_target_property(minitest_type Atliac::minitest TYPE)
     # If the Atliac::minitest is a static library, it can only be linked to static libraries or executables.
@@ -24,8 +27,9 @@ function(minitest_discover_tests target)
     if(BUILD_TESTING)
     set(guid ${target}_B06065BA2B364445A11B6E98E779BBA1)
     add_custom_command(TARGET ${target} POST_BUILD
-        COMMAND "$<TARGET_FILE:${target}>" --minitest-pri-impl-discover-test-cases ${guid} ${CMAKE_CURRENT_BINARY_DIR}/CTestTestfile.cmake
-        COMMENT "Discovering tests for ${target}")
+        COMMAND "$<TARGET_FILE:${target}>" --minitest-pri-impl-discover-test-cases ${guid} ${CMAKE_CURRENT_BINARY_DIR}/CTestTestfile.cmake ${arg_FILTER}
+        COMMENT "Discovering tests for ${target}"
+        VERBATIM)
     # This is needed for Test Explorer to discover tests
     add_test(NOT_BUILT_${guid} "${guid}")
     endif(BUILD_TESTING)
@@ -0,0 +1,117 @@
+#include <Atliac/minitest_async.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif // __linux__
+
+using namespace std::chrono_literals;
+
+namespace
+{
+minitest::task<int> add_later(int a, int b)
+{
+    co_await minitest::sleep_for(1ms);
+    co_return a + b;
+}
+
+minitest::task<> fail_later()
+{
+    co_await minitest::yield();
+    ASSERT_TRUE(false);
+}
+} // namespace
+
+ASYNC_TEST_CASE("async: await tasks")
+{
+    auto sum = co_await add_later(1, 2);
+    ASSERT_TRUE(sum == 3);
+    EXPECT_TRUE(co_await add_later(sum, 4) == 7);
+}
+
+ASYNC_TEST_CASE("async: interleave spawned tasks")
+{
+    auto &loop = *minitest::event_loop::current();
+    std::vector<int> order;
+    int done = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i)
+    {
+        loop.spawn(
+            [](std::vector<int> &order, int &done, int i, auto wake_up) -> minitest::task<>
+            {
+                co_await minitest::sleep_until(wake_up);
+                order.push_back(i);
+                ++done;
+            }(order, done, i, start + std::chrono::microseconds((1000 - i) * 2)));
+    }
+    while (done < 1000) { co_await minitest::sleep_for(1ms); }
+    ASSERT_TRUE(order.size() == 1000);
+    EXPECT_TRUE(order.front() == 999 && order.back() == 0);
+}
+
+#ifdef __linux__
+ASYNC_TEST_CASE("async: wait for fds")
+{
+    int fds[2];
+    ASSERT_TRUE(pipe(fds) == 0);
+    minitest::event_loop::current()->spawn(
+        [](int fd) -> minitest::task<>
+        {
+            co_await minitest::sleep_for(1ms);
+            co_await minitest::wait_writable(fd);
+            ASSERT_TRUE(write(fd, "x", 1) == 1);
+        }(fds[1]));
+    co_await minitest::wait_readable(fds[0]);
+    char c = 0;
+    EXPECT_TRUE(read(fds[0], &c, 1) == 1 && c == 'x');
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif // __linux__
+
+TEST_CASE("Failure Test: async assertion failures")
+{
+    minitest::event_loop loop;
+    try
+    {
+        loop.run(fail_later());
+        FAIL("the assertion failure is not propagated");
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+    }
+    auto spawn_failure = [&]() -> minitest::task<>
+    {
+        minitest::event_loop::current()->spawn(fail_later());
+        co_await minitest::sleep_for(10ms);
+    };
+    try
+    {
+        loop.run(spawn_failure());
+        FAIL("the assertion failure of the spawned task is not propagated");
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+    }
+}
+
+TEST_CASE("Failure Test: blocked async test case")
+{
+    struct never
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        void await_resume() const noexcept {}
+    };
+    minitest::event_loop loop;
+    try
+    {
+        loop.run([]() -> minitest::task<> { co_await never{}; }());
+        FAIL("the blocked task is not detected");
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+    }
+}
@@ -1,5 +1,14 @@
 #include <Atliac/minitest.h>
 
+namespace
+{
+struct basic_fixture
+{
+};
+} // namespace
+
+FIXTURE(basic_fixture, test_case);
+
 inline void test_case()
 {
 
@@ -43,6 +52,8 @@ inline void test_case()
     INFO("msg 1");
     INFO("msg 1", ",msg 2");
     INFO("msg 1", ",msg 2", ",msg 3");
+
+    [[maybe_unused]] auto &fixture = minitest::fixture<basic_fixture>();
 }
 
-TEST_CASE("Basic Compilation Test") { test_case(); }
\ No newline at end of file
+TEST_CASE("Basic Compilation Test", "basic") { test_case(); }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <Atliac/minitest_async.h>
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+static_assert(std::chrono::is_clock_v<minitest::clock>);
+
+// allows one request per interval
+template <class Clock> class rate_limiter
+{
+  public:
+    explicit rate_limiter(typename Clock::duration interval) : interval_(interval) {}
+
+    bool allow()
+    {
+        auto now = Clock::now();
+        if (now < next_) { return false; }
+        next_ = now + interval_;
+        return true;
+    }
+
+  private:
+    typename Clock::duration interval_;
+    typename Clock::time_point next_{};
+};
+} // namespace
+
+TEST_CASE("clock: advance")
+{
+    rate_limiter<minitest::clock> limiter(500ms);
+    ASSERT_TRUE(limiter.allow());
+    EXPECT_FALSE(limiter.allow());
+    minitest::clock::advance(499ms);
+    EXPECT_FALSE(limiter.allow());
+    minitest::clock::advance(1ms);
+    EXPECT_TRUE(limiter.allow());
+
+    auto now = minitest::clock::now();
+    minitest::clock::advance(-1s);
+    EXPECT_TRUE(minitest::clock::now() == now);
+}
+
+ASYNC_TEST_CASE("clock: auto advance when idle")
+{
+    auto real_start = std::chrono::steady_clock::now();
+    auto start = minitest::clock::now();
+    co_await minitest::sleep_for<minitest::clock>(1h);
+    EXPECT_TRUE(minitest::clock::now() - start == 1h);
+    EXPECT_TRUE(std::chrono::steady_clock::now() - real_start < 1s);
+}
+
+ASYNC_TEST_CASE("clock: run until idle")
+{
+    bool timed_out = false;
+    minitest::event_loop::current()->spawn(
+        [](bool &timed_out) -> minitest::task<>
+        {
+            co_await minitest::sleep_for<minitest::clock>(500ms);
+            timed_out = true;
+        }(timed_out));
+    co_await minitest::run_until_idle();
+    EXPECT_FALSE(timed_out);
+    minitest::clock::advance(499ms);
+    co_await minitest::run_until_idle();
+    EXPECT_FALSE(timed_out);
+    minitest::clock::advance(1ms);
+    co_await minitest::run_until_idle();
+    EXPECT_TRUE(timed_out);
+}
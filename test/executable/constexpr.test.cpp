@@ -0,0 +1,39 @@
+#include <Atliac/minitest_core.h>
+#include <cstdint>
+#include <string_view>
+
+namespace
+{
+constexpr std::uint32_t fnv1a(std::string_view s)
+{
+    std::uint32_t hash = 2166136261u;
+    for (auto c : s) { hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u; }
+    return hash;
+}
+
+constexpr int parse_int(std::string_view s)
+{
+    int value = 0;
+    for (auto c : s)
+    {
+        if (c < '0' || c > '9') { throw "not a number"; }
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+} // namespace
+
+CONSTEXPR_TEST_CASE("constexpr: fnv1a", "constexpr")
+{
+    ASSERT_TRUE(fnv1a("") == 2166136261u);
+    ASSERT_TRUE(fnv1a("a") == 0xe40c292cu, "fnv1a(\"a\")");
+    EXPECT_FALSE(fnv1a("a") == fnv1a("b"));
+    SUCCEED();
+}
+
+CONSTEXPR_TEST_CASE("constexpr: parse_int", "constexpr")
+{
+    ASSERT_TRUE(parse_int("0") == 0);
+    ASSERT_TRUE(parse_int("2024") == 2024);
+    INFO("parse_int passed");
+}
@@ -0,0 +1,54 @@
+// only the light header, the messages are formatted by minitest.cpp
+#include <Atliac/minitest_core.h>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+struct core_fixture
+{
+    int value = 42;
+};
+} // namespace
+
+FIXTURE(core_fixture, process);
+
+TEST_CASE("core: assertions", "core")
+{
+    std::string name = "minitest";
+    ASSERT_TRUE(name.size() == 8, "name: ", name, ", size: ", name.size());
+    ASSERT_FALSE(name.empty(), std::string_view("not empty"), ' ', true, ' ', 1.5, ' ', -1, ' ', 2u, ' ', nullptr);
+    ASSERT_THROW(throw 1, int, "throw int");
+    ASSERT_NO_THROW((void)name.at(0));
+    EXPECT_TRUE(minitest::fixture<core_fixture>().value == 42);
+    EXPECT_THROW((void)name.at(8), std::out_of_range);
+    EXPECT_NO_THROW((void)name.at(7));
+    INFO("core: ", name, ' ', typeid(name));
+}
+
+TEST_CASE("core: message arguments", "core")
+{
+    std::ostringstream ss;
+    const unsigned char text[] = "text";
+    for (minitest::pri_impl::message_arg arg : {minitest::pri_impl::message_arg('a'), {std::int8_t{'b'}},
+             {std::uint8_t{'c'}}, {static_cast<const unsigned char *>(text)}, {std::int16_t{1}}})
+    {
+        arg.print(ss);
+    }
+    EXPECT_TRUE(ss.str() == "abctext1", ss.str());
+}
+
+TEST_CASE("Failure Test: core assertion failure", "core")
+{
+    try
+    {
+        ASSERT_NO_THROW((void)std::string().at(1), "custom message ", 1);
+        FAIL("ASSERT_NO_THROW passed");
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+    }
+}
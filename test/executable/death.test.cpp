@@ -0,0 +1,83 @@
+#include <Atliac/minitest.h>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+// returns the failure message of the assertion, or an empty string if the assertion passed
+std::string assertion_failure(auto &&assertion)
+{
+    std::ostringstream ss;
+    auto cout_buff = std::cout.rdbuf(ss.rdbuf());
+    try
+    {
+        assertion();
+        ss.str("");
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+    }
+    std::cout.rdbuf(cout_buff);
+    return ss.str();
+}
+} // namespace
+
+#ifndef _WIN32
+TEST_CASE("death: ASSERT_DEATH")
+{
+    ASSERT_DEATH(std::abort(), "");
+    ASSERT_DEATH(
+        {
+            std::cerr << "fatal error: out of memory" << std::endl;
+            std::exit(3);
+        },
+        "fatal error: .* memory");
+    EXPECT_DEATH(std::raise(SIGSEGV), "");
+}
+
+TEST_CASE("death: ASSERT_EXIT")
+{
+    ASSERT_EXIT(std::exit(0), minitest::exited_with_code{0}, "");
+    ASSERT_EXIT(std::_Exit(42), minitest::exited_with_code{42}, "");
+    ASSERT_EXIT(std::abort(), minitest::killed_by_signal{SIGABRT}, "");
+    EXPECT_EXIT(std::raise(SIGTERM), minitest::killed_by_signal{SIGTERM}, "");
+}
+
+TEST_CASE("Failure Test: the statement doesn't die")
+{
+    auto message = assertion_failure([] { ASSERT_DEATH((void)0, ""); });
+    EXPECT_TRUE(message.find("returned instead of terminating") != std::string::npos, message);
+    message = assertion_failure([] { ASSERT_DEATH(throw 1, ""); });
+    EXPECT_TRUE(message.find("threw an exception") != std::string::npos, message);
+    message = assertion_failure([] { ASSERT_DEATH(std::exit(0), ""); });
+    EXPECT_TRUE(message.find("exited with the code 0") != std::string::npos, message);
+}
+
+TEST_CASE("Failure Test: the death test doesn't match")
+{
+    auto message = assertion_failure([] { ASSERT_EXIT(std::exit(1), minitest::exited_with_code{2}, ""); });
+    EXPECT_TRUE(message.find("exited with the code 1") != std::string::npos, message);
+    message = assertion_failure([] {
+        ASSERT_DEATH(
+            {
+                std::cerr << "unexpected output";
+                std::abort();
+            },
+            "^expected output");
+    });
+    EXPECT_TRUE(message.find("The stderr output:\nunexpected output") != std::string::npos, message);
+}
+
+TEST_CASE("Failure Test: the death test times out")
+{
+    minitest::set_death_test_timeout(0.1);
+    auto message =
+        assertion_failure([] { ASSERT_DEATH(std::this_thread::sleep_for(std::chrono::seconds(10)), ""); });
+    minitest::set_death_test_timeout(60);
+    EXPECT_TRUE(message.find("didn't terminate the process in 0.1 seconds") != std::string::npos, message);
+}
+#endif // _WIN32
@@ -0,0 +1,75 @@
+#include <Atliac/minitest.h>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace
+{
+// returns the names of the test cases listed with the filter
+auto list_test_cases(const char *filter)
+{
+    std::set<std::string> test_case_names;
+    std::ostringstream ss;
+    auto cout_buff = std::cout.rdbuf(ss.rdbuf());
+    const int argc = 4;
+    const char *argv[] = {"_", minitest::pri_impl::flag_list_test_cases, minitest::pri_impl::flag_filter, filter};
+    auto rt = minitest::pri_impl::run_test(argc, argv);
+    auto result = ss.str();
+    std::cout.rdbuf(cout_buff);
+    ASSERT_TRUE(rt == MINITEST_SUCCESS, result);
+    std::regex re(R"(\d+:(.+)\()");
+    std::smatch match;
+    while (std::regex_search(result, match, re))
+    {
+        test_case_names.insert(match[1]);
+        result = match.suffix();
+    }
+    return test_case_names;
+}
+} // namespace
+
+TEST_CASE("filter.a", "fast") {}
+
+TEST_CASE("filter.b", "fast", "io") {}
+
+TEST_CASE("filter.c", "slow") {}
+
+// excluded from CTest by the FILTER of minitest_discover_tests
+TEST_CASE("filter: manual", "manual") {}
+
+TEST_CASE("filter: tags")
+{
+    using names = std::set<std::string>;
+    EXPECT_TRUE(list_test_cases("[fast]") == (names{"filter.a", "filter.b"}));
+    EXPECT_TRUE(list_test_cases("[fast] && ![io]") == (names{"filter.a"}));
+    EXPECT_TRUE(list_test_cases("[slow] || [io]") == (names{"filter.b", "filter.c"}));
+    EXPECT_TRUE(list_test_cases("[no such tag]").empty());
+}
+
+TEST_CASE("filter: names")
+{
+    using names = std::set<std::string>;
+    EXPECT_TRUE(list_test_cases("filter.?") == (names{"filter.a", "filter.b", "filter.c"}));
+    EXPECT_TRUE(list_test_cases("filter.* && !filter.c") == (names{"filter.a", "filter.b"}));
+    EXPECT_TRUE(list_test_cases("filter.a||filter.c") == (names{"filter.a", "filter.c"}));
+    EXPECT_TRUE(list_test_cases("\"filter: manual\"") == (names{"filter: manual"}));
+    EXPECT_TRUE(list_test_cases("filter* && !(filter:* || [slow])") == (names{"filter.a", "filter.b"}));
+}
+
+TEST_CASE("filter: run")
+{
+    const int argc = 3;
+    const char *argv[] = {"_", minitest::pri_impl::flag_filter, "[fast] || [slow]"};
+    ASSERT_TRUE(minitest::pri_impl::run_test(argc, argv) == MINITEST_SUCCESS);
+}
+
+TEST_CASE("Failure Test: invalid filter")
+{
+    for (auto filter : {"[fast", "(filter.a", "filter.a &&", "\"filter.a", "filter.a)"})
+    {
+        const int argc = 3;
+        const char *argv[] = {"_", minitest::pri_impl::flag_filter, filter};
+        EXPECT_TRUE(minitest::pri_impl::run_test(argc, argv) == MINITEST_FAILURE, filter);
+    }
+}
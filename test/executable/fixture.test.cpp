@@ -0,0 +1,82 @@
+#include <Atliac/minitest.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+int dataset_constructions = 0;
+int scratch_instances = 0;
+
+struct dataset
+{
+    std::vector<int> values;
+
+    dataset() : values{1, 2, 3} { ++dataset_constructions; }
+};
+
+struct scratch
+{
+    // a fixture may use other fixtures
+    const dataset &source = minitest::fixture<dataset>();
+
+    scratch() { ++scratch_instances; }
+
+    ~scratch() { --scratch_instances; }
+};
+
+struct unregistered_fixture
+{
+};
+} // namespace
+
+FIXTURE(dataset, process);
+FIXTURE(scratch, test_case);
+
+TEST_CASE("fixture: process scope")
+{
+    auto &a = minitest::fixture<dataset>();
+    auto &b = minitest::fixture<dataset>();
+    ASSERT_TRUE(&a == &b);
+    ASSERT_TRUE(a.values.size() == 3);
+
+    std::vector<const dataset *> shared(4);
+    std::vector<std::thread> threads;
+    for (auto &p : shared)
+    {
+        threads.emplace_back([&p] { p = &minitest::fixture<dataset>(); });
+    }
+    for (auto &t : threads) { t.join(); }
+    for (auto p : shared) { EXPECT_TRUE(p == &a); }
+    EXPECT_TRUE(dataset_constructions == 1);
+}
+
+TEST_CASE("fixture: test case scope user")
+{
+    auto &s = minitest::fixture<scratch>();
+    ASSERT_TRUE(&s == &minitest::fixture<scratch>());
+    ASSERT_TRUE(&s.source == &minitest::fixture<dataset>());
+    ASSERT_TRUE(scratch_instances == 1);
+}
+
+TEST_CASE("fixture: test case scope")
+{
+    const int argc = 3;
+    const char *argv[] = {"_", minitest::pri_impl::flag_run_test_case, "fixture: test case scope user"};
+    ASSERT_TRUE(minitest::pri_impl::run_test(argc, argv) == MINITEST_SUCCESS);
+    ASSERT_TRUE(scratch_instances == 0);
+    ASSERT_TRUE(minitest::pri_impl::run_test(argc, argv) == MINITEST_SUCCESS);
+    ASSERT_TRUE(scratch_instances == 0);
+}
+
+TEST_CASE("Failure Test: unregistered fixture")
+{
+    try
+    {
+        (void)minitest::fixture<unregistered_fixture>();
+    }
+    catch (const minitest::minitest_assertion_failure &)
+    {
+        return;
+    }
+    FAIL("an unregistered fixture should fail the test case");
+}
@@ -0,0 +1,77 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+int flaky_runs = 0;
+int repeat_runs = 0;
+} // namespace
+
+// fails at the first run, a retry in a forked child inherits the counter
+TEST_CASE("flaky.case", "manual") { ASSERT_TRUE(++flaky_runs > 1); }
+
+TEST_CASE("repeat.case", "manual") { ++repeat_runs; }
+
+TEST_CASE("repeat.fails at the 10th run", "manual") { ASSERT_TRUE(++repeat_runs < 10); }
+
+TEST_CASE("flaky: retries and stats")
+{
+    auto stats_file = std::filesystem::temp_directory_path() / "minitest_flaky_stats_test.txt";
+    std::filesystem::remove(stats_file);
+    auto stats_flag = minitest::pri_impl::flag_flaky_stats + ("=" + stats_file.string());
+
+    flaky_runs = 0;
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "flaky.case", stats_flag.c_str()});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("Failed: flaky.case") != std::string::npos, output);
+
+    flaky_runs = 0;
+    std::tie(rt, output) =
+        run_test({minitest::pri_impl::flag_filter, "flaky.case", "--minitest-retries=2", stats_flag.c_str()});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("Flaky: flaky.case") != std::string::npos, output);
+    EXPECT_TRUE(output.find("flaky.case: failure rate 75.0% (2 of 2 runs failed, 1 flaky)") != std::string::npos,
+        output);
+
+    std::ifstream ifs(stats_file);
+    std::stringstream stats;
+    stats << ifs.rdbuf();
+    EXPECT_TRUE(stats.str().find("\n2 2 1 3 flaky.case\n") != std::string::npos, stats.str());
+    ifs.close();
+    std::filesystem::remove(stats_file);
+}
+
+TEST_CASE("flaky: repeat")
+{
+    repeat_runs = 0;
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "repeat.case", "--minitest-repeat=1000"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(repeat_runs == 1000);
+
+    repeat_runs = 0;
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_filter, "repeat.fails at the 10th run",
+        "--minitest-repeat=0", minitest::pri_impl::flag_until_fail});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(repeat_runs == 10);
+    EXPECT_TRUE(output.find("repeat.fails at the 10th run failed in the iteration 9") != std::string::npos, output);
+
+    // until a failure implies no limit
+    repeat_runs = 0;
+    std::tie(rt, output) = run_test(
+        {minitest::pri_impl::flag_filter, "repeat.fails at the 10th run", minitest::pri_impl::flag_until_fail});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(repeat_runs == 10);
+
+    // the repeated runs keep no per-test-case bookkeeping
+    std::tie(rt, output) =
+        run_test({minitest::pri_impl::flag_filter, "repeat.case", "--minitest-repeat=2", "--minitest-retries=1"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("minitest: --minitest-retries can't be combined with --minitest-repeat") !=
+                    std::string::npos,
+        output);
+}
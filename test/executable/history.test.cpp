@@ -0,0 +1,57 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::chrono::milliseconds history_sleep{0};
+bool history_fails = false;
+} // namespace
+
+TEST_CASE("history.sleep", "manual") { std::this_thread::sleep_for(history_sleep); }
+
+TEST_CASE("history.maybe fails", "manual") { ASSERT_FALSE(history_fails); }
+
+TEST_CASE("history: record and report")
+{
+    auto history_file = std::filesystem::temp_directory_path() / "minitest_history_test.bin";
+    std::filesystem::remove(history_file);
+    auto history_flag = minitest::pri_impl::flag_history + ("=" + history_file.string());
+
+    for (int run = 0; run < 30; ++run)
+    {
+        history_sleep = std::chrono::milliseconds(run < 20 ? 0 : 5);
+        history_fails = run == 3;
+        auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "history.*", history_flag.c_str()});
+        EXPECT_TRUE(rt == (history_fails ? MINITEST_FAILURE : MINITEST_SUCCESS), output);
+    }
+    // the names are recorded once, the results are fixed-size records
+    EXPECT_TRUE(std::filesystem::file_size(history_file) == 32 + 2 * 64 + 60 * 32);
+
+    auto [rt, output] = run_test({minitest::pri_impl::flag_history_report, history_flag.c_str()});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("30 test runs of 2 test cases") != std::string::npos, output);
+    EXPECT_TRUE(output.find("    history.maybe fails: 30 runs, 1 failed, 0 flaky, p50 ") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Drifted: history.sleep, p50 ") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Drifted: history.maybe fails") == std::string::npos, output);
+    std::filesystem::remove(history_file);
+}
+
+TEST_CASE("Failure Test: invalid history file")
+{
+    auto history_file = std::filesystem::temp_directory_path() / "minitest_history_invalid.bin";
+    std::ofstream(history_file) << "not a history file, but long enough for a header";
+    auto history_flag = minitest::pri_impl::flag_history + ("=" + history_file.string());
+    auto [rt, output] = run_test({minitest::pri_impl::flag_history_report, history_flag.c_str()});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("is not a minitest history file") != std::string::npos, output);
+    std::filesystem::remove(history_file);
+
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_history_report});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+}
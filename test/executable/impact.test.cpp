@@ -0,0 +1,99 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__GNUC__)
+// this file isn't built with -fsanitize-coverage=trace-pc-guard, the test cases call the callbacks to simulate it
+MINITEST_RECORD_COVERAGE();
+
+namespace
+{
+std::uint32_t impact_guards[2];
+// the guards stay registered for the rest of the process
+bool impact_guards_registered = false;
+} // namespace
+
+TEST_CASE("impact.covered", "manual")
+{
+    // The recorder attributes a hit to the source file of the return address of the callback, like the calls inserted
+    // by the instrumentation. The call is made through a volatile pointer so it isn't inlined, and isn't a tail call
+    // which would return to the runner directly.
+    void (*volatile trace_pc_guard)(std::uint32_t *) = __sanitizer_cov_trace_pc_guard;
+    trace_pc_guard(&impact_guards[0]);
+    asm volatile("");
+}
+
+TEST_CASE("impact.not covered", "manual") {}
+
+TEST_CASE("impact.new", "manual") {}
+
+TEST_CASE("impact: record the index and select the impacted test cases")
+{
+    auto index_file = std::filesystem::temp_directory_path() / "minitest_impact_test.txt";
+    auto index_flag = minitest::pri_impl::flag_impact_index + ("=" + index_file.string());
+    int rt = 0;
+    std::string output;
+
+    if (!impact_guards_registered)
+    {
+        std::tie(rt, output) = run_test({index_flag.c_str(), minitest::pri_impl::flag_filter, "impact.*"});
+        EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+        EXPECT_TRUE(output.find("built with -fsanitize-coverage=trace-pc-guard") != std::string::npos, output);
+        __sanitizer_cov_trace_pc_guard_init(impact_guards, impact_guards + 2);
+        impact_guards_registered = true;
+    }
+    std::tie(rt, output) = run_test(
+        {index_flag.c_str(), minitest::pri_impl::flag_filter, "impact.covered || impact.not covered"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("minitest: recorded the source files of 2 test cases in the impact index") !=
+                    std::string::npos,
+        output);
+    std::ifstream ifs(index_file);
+    std::string index((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+    // addr2line needs the debug information of this file
+    EXPECT_TRUE(index.starts_with("minitest impact index 1\n1\n"), index);
+    EXPECT_TRUE(index.find("/test/executable/impact.test.cpp\n0\timpact.covered\n\timpact.not covered\n") !=
+                    std::string::npos,
+        index);
+
+    // the new test case isn't in the index
+    for (auto changed_files : {"test/executable/impact.test.cpp", "other.cpp,executable/impact.test.cpp"})
+    {
+        auto changed_files_flag = minitest::pri_impl::flag_changed_files + ("=" + std::string(changed_files));
+        std::tie(rt, output) = run_test(
+            {index_flag.c_str(), changed_files_flag.c_str(), minitest::pri_impl::flag_filter, "impact.*"});
+        EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+        EXPECT_TRUE(output.find("2 of 3 test cases are impacted by the changed files, 1 of them not in the impact "
+                                "index") != std::string::npos,
+            output);
+        EXPECT_TRUE(output.find("impact.covered passed") != std::string::npos, output);
+        EXPECT_TRUE(output.find("impact.not covered passed") == std::string::npos, output);
+    }
+    std::tie(rt, output) = run_test({index_flag.c_str(), "--minitest-changed-files=impact.test.cpp.orig",
+        minitest::pri_impl::flag_filter, "impact.covered || impact.new"});
+    EXPECT_TRUE(output.find("1 of 2 test cases are impacted") != std::string::npos, output);
+    EXPECT_TRUE(output.find("impact.new passed") != std::string::npos, output);
+    std::filesystem::remove(index_file);
+}
+
+TEST_CASE("Failure Test: changed files without an impact index")
+{
+    auto [rt, output] = run_test({"--minitest-changed-files=a.cpp"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("--minitest-changed-files requires --minitest-impact-index=<file>") != std::string::npos,
+        output);
+
+    auto index_file = std::filesystem::temp_directory_path() / "minitest_impact_invalid.txt";
+    std::ofstream(index_file) << "not an impact index\n";
+    auto index_flag = minitest::pri_impl::flag_impact_index + ("=" + index_file.string());
+    std::tie(rt, output) = run_test({index_flag.c_str(), "--minitest-changed-files=a.cpp"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("is not a minitest impact index") != std::string::npos, output);
+    std::filesystem::remove(index_file);
+}
+#endif // defined(__linux__) && defined(__GNUC__)
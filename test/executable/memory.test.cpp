@@ -0,0 +1,71 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// counts the live allocations of the whole test executable
+MINITEST_COUNT_ALLOCATIONS();
+
+using namespace minitest::literals;
+
+namespace
+{
+std::vector<int *> leaked;
+} // namespace
+
+TEST_CASE("memory.leak", "manual") { leaked.push_back(new int(1)); }
+
+TEST_CASE("memory.no leak", "manual")
+{
+    std::vector<int> v(1000);
+    auto p = std::make_unique<int>(2);
+}
+
+TEST_CASE("memory.too much", "manual")
+{
+    auto buffer = std::make_unique<char[]>(32_MiB);
+    std::memset(buffer.get(), 1, 32_MiB);
+    ASSERT_PEAK_RSS_BELOW(16_MiB, "the buffer is resident");
+}
+
+TEST_CASE("memory: literals")
+{
+    static_assert(1_KiB == 1024 && 64_MiB == 64 * 1024 * 1024 && 2_GiB == 2ull * 1024 * 1024 * 1024);
+}
+
+TEST_CASE("memory: live allocations")
+{
+    auto before = minitest::get_memory_usage().live_allocations;
+    auto p = std::make_unique<int>(1);
+    EXPECT_TRUE(minitest::get_memory_usage().live_allocations == before + 1);
+    p.reset();
+    EXPECT_TRUE(minitest::get_memory_usage().live_allocations == before);
+}
+
+TEST_CASE("memory: leak check")
+{
+    leaked.reserve(4);
+    // memory.leak runs first, the allocation of the buffer of the captured output is attributed to it
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "memory.leak || memory.no leak",
+        minitest::pri_impl::flag_check_memory});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("Leaking: memory.leak (") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Leaking: memory.no leak") == std::string::npos, output);
+    EXPECT_TRUE(output.find("memory.no leak memory: rss ") != std::string::npos, output);
+    for (auto p : leaked) { delete p; }
+    leaked.clear();
+}
+
+#ifdef __linux__
+TEST_CASE("memory: peak RSS")
+{
+    EXPECT_PEAK_RSS_BELOW(1_GiB);
+    auto [rt, output] = run_test({minitest::pri_impl::flag_run_test_case, "memory.too much"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("minitest ASSERT_PEAK_RSS_BELOW(16_MiB) failed: The peak RSS is ") != std::string::npos,
+        output);
+    EXPECT_TRUE(minitest::get_memory_usage().rss > 0);
+}
+#endif // __linux__
@@ -0,0 +1,56 @@
+// built with -fno-exceptions where supported, a failed assertion longjmps back to the runner
+#define MINITEST_CONFIG_NO_EXCEPTIONS
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+int statements_after_failure = 0;
+} // namespace
+
+TEST_CASE("no_exceptions.assert", "manual")
+{
+    ASSERT_TRUE(1 + 1 == 3, "longjmp");
+    ++statements_after_failure;
+}
+
+TEST_CASE("no_exceptions.fail", "manual")
+{
+    FAIL();
+    ++statements_after_failure;
+}
+
+TEST_CASE("no_exceptions.expect", "manual")
+{
+    EXPECT_FALSE(true);
+    ++statements_after_failure;
+}
+
+TEST_CASE("no_exceptions.pass", "manual") { ASSERT_TRUE(true); }
+
+TEST_CASE("no exceptions: failed assertions")
+{
+    statements_after_failure = 0;
+    for (auto name : {"no_exceptions.assert", "no_exceptions.fail", "no_exceptions.expect"})
+    {
+        auto [rt, output] = try_run_test({minitest::pri_impl::flag_run_test_case, name});
+        EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    }
+    // only the expectation doesn't end the test case
+    EXPECT_TRUE(statements_after_failure == 1);
+
+    auto [rt, output] = try_run_test({minitest::pri_impl::flag_filter, "no_exceptions.*"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("no_exceptions.pass passed") != std::string::npos, output);
+}
+
+TEST_CASE("no exceptions: not a test run")
+{
+    auto [rt, output] = try_run_test({"--not-a-minitest-flag"});
+    EXPECT_TRUE(rt == PRI_IMPL_MINITEST_NOT_TEST_RUN, output);
+    EXPECT_TRUE(output.empty(), output);
+}
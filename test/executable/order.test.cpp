@@ -0,0 +1,80 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// returns the test cases in the order they ran
+auto run_order(const std::string &output)
+{
+    std::vector<std::string> order;
+    std::istringstream ss(output);
+    const std::string prefix = "Running the test case: ";
+    for (std::string line; std::getline(ss, line);)
+    {
+        if (line.starts_with(prefix)) { order.push_back(line.substr(prefix.size())); }
+    }
+    return order;
+}
+
+bool polluted = false;
+} // namespace
+
+TEST_CASE("shuffle.0", "shuffle", "manual") {}
+
+TEST_CASE("shuffle.1", "shuffle", "manual") {}
+
+TEST_CASE("shuffle.2", "shuffle", "manual") {}
+
+TEST_CASE("shuffle.3", "shuffle", "manual") {}
+
+TEST_CASE("shuffle.4", "shuffle", "manual") {}
+
+TEST_CASE("shuffle.5", "shuffle", "manual") {}
+
+TEST_CASE("shuffle: reproducible with the seed")
+{
+    auto [rt1, output1] = run_test({minitest::pri_impl::flag_filter, "[shuffle]", "--minitest-shuffle=2024"});
+    auto [rt2, output2] = run_test({"--minitest-shuffle=2024", minitest::pri_impl::flag_filter, "[shuffle]"});
+    auto [rt3, output3] = run_test({minitest::pri_impl::flag_filter, "[shuffle]"});
+    ASSERT_TRUE(rt1 == MINITEST_SUCCESS && rt2 == MINITEST_SUCCESS && rt3 == MINITEST_SUCCESS);
+    EXPECT_TRUE(output1.find("seed 2024") != std::string::npos, output1);
+    auto order1 = run_order(output1);
+    EXPECT_TRUE(order1.size() == 6);
+    EXPECT_TRUE(order1 == run_order(output2));
+    EXPECT_TRUE(order1 != run_order(output3), "the chance that a shuffle keeps the order is 1/720");
+}
+
+TEST_CASE("Failure Test: invalid shuffle seed")
+{
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "[shuffle]", "--minitest-shuffle=seed"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+}
+
+// `order.victim` only passes if `order.polluter` didn't run before it in the same process
+TEST_CASE("order.neutral 1", "order", "manual") {}
+
+TEST_CASE("order.neutral 2", "order", "manual") {}
+
+TEST_CASE("order.polluter", "order", "manual") { polluted = true; }
+
+TEST_CASE("order.neutral 3", "order", "manual") {}
+
+TEST_CASE("order.victim", "order", "manual") { ASSERT_FALSE(polluted); }
+
+TEST_CASE("order.z neutral", "order", "manual") {}
+
+#ifndef _WIN32
+TEST_CASE("order: detect the polluter")
+{
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "[order]", "--minitest-detect-order-deps"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("order.victim depends on the test order, it fails after:\n    order.polluter\n") !=
+                    std::string::npos,
+        output);
+    // the test cases ran in child processes
+    EXPECT_FALSE(polluted);
+}
+#endif // _WIN32
@@ -0,0 +1,78 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <cerrno>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+int placed_cpu = -1;
+
+// restores the CPUs and the memory policy of the test program at the end of the scope
+struct placement_guard
+{
+    placement_guard() { sched_getaffinity(0, sizeof(cpus), &cpus); }
+    placement_guard(const placement_guard &) = delete;
+    placement_guard &operator=(const placement_guard &) = delete;
+    ~placement_guard()
+    {
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+        // MPOL_DEFAULT
+        syscall(SYS_set_mempolicy, 0, nullptr, 0);
+    }
+    cpu_set_t cpus;
+};
+} // namespace
+
+TEST_CASE("placement.cpu", "manual") { placed_cpu = sched_getcpu(); }
+
+TEST_CASE("placement: run on the selected CPU")
+{
+    placement_guard guard;
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &guard.cpus)) { ++cpu; }
+    auto cpus_flag = minitest::pri_impl::flag_cpus + ("=" + std::to_string(cpu));
+    auto [rt, output] = run_test({cpus_flag.c_str(), minitest::pri_impl::flag_filter, "placement.cpu"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("minitest: running on the CPUs " + std::to_string(cpu) + "\n") != std::string::npos, output);
+    EXPECT_TRUE(placed_cpu == cpu, placed_cpu);
+}
+
+TEST_CASE("placement: run on a NUMA node")
+{
+    placement_guard guard;
+    auto [rt, output] = run_test({"--minitest-numa-node=4096", minitest::pri_impl::flag_filter, "placement.cpu"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("the NUMA node 4096 doesn't exist") != std::string::npos, output);
+
+    // kernels without NUMA, and containers denying set_mempolicy without CAP_SYS_NICE
+    std::string node_cpus;
+    std::getline(std::ifstream("/sys/devices/system/node/node0/cpulist"), node_cpus);
+    if (node_cpus.empty() || (syscall(SYS_set_mempolicy, 0, nullptr, 0) && (errno == EPERM || errno == ENOSYS)))
+    {
+        SUCCEED("NUMA placement is not supported here, skipped");
+        return;
+    }
+    std::tie(rt, output) = run_test({"--minitest-numa-node=0", minitest::pri_impl::flag_filter, "placement.cpu"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("minitest: running on the CPUs ") != std::string::npos, output);
+}
+
+TEST_CASE("Failure Test: invalid CPU lists")
+{
+    for (auto flag : {"--minitest-cpus=3-1", "--minitest-cpus=x", "--minitest-cpus=0,", "--minitest-cpus=1024"})
+    {
+        auto [rt, output] = run_test({flag, minitest::pri_impl::flag_filter, "placement.cpu"});
+        EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+        EXPECT_TRUE(output.find("minitest: invalid value of --minitest-cpus") != std::string::npos, output);
+    }
+    auto [rt, output] = run_test({minitest::pri_impl::flag_cpus, minitest::pri_impl::flag_filter, "placement.cpu"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("minitest: --minitest-cpus requires a list of CPUs") != std::string::npos, output);
+}
+#endif // __linux__
@@ -0,0 +1,68 @@
+#include <Atliac/minitest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+int cached_square(int x)
+{
+    static int cache[16]{};
+    if (!cache[x])
+    {
+        MINITEST_COUNTER("probe.cache.miss");
+        MINITEST_SCOPED_TIMER("probe.cache.fill");
+        cache[x] = x * x + 1;
+    }
+    return cache[x] - 1;
+}
+} // namespace
+
+TEST_CASE("probe: counters")
+{
+    for (int x = 0; x < 16; ++x) { cached_square(x); }
+    minitest::reset_probes();
+    for (int x = 0; x < 16; ++x) { EXPECT_TRUE(cached_square(x) == x * x); }
+    EXPECT_COUNTER_EQ("probe.cache.miss", 0);
+    EXPECT_COUNTER_EQ("probe.never incremented", 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back(
+            []
+            {
+                for (int i = 0; i < 10000; ++i) { MINITEST_COUNTER_ADD("probe.threads", 2); }
+            });
+    }
+    for (auto &t : threads) { t.join(); }
+    ASSERT_COUNTER_EQ("probe.threads", 160000);
+}
+
+TEST_CASE("probe: histogram buckets")
+{
+    using minitest::pri_impl::histogram_probe;
+    for (std::uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 100ull, 1000000ull, ~0ull})
+    {
+        auto index = histogram_probe::bucket_index(value);
+        EXPECT_TRUE(index < histogram_probe::bucket_count, value);
+        EXPECT_TRUE(histogram_probe::bucket_lower_bound(index) <= value, value);
+        if (index + 1 < histogram_probe::bucket_count)
+        {
+            EXPECT_TRUE(value < histogram_probe::bucket_lower_bound(index + 1), value);
+        }
+    }
+}
+
+TEST_CASE("probe: dump")
+{
+    minitest::reset_probes();
+    for (int i = 1; i <= 100; ++i) { MINITEST_HISTOGRAM("probe.sizes", i); }
+    std::ostringstream ss;
+    minitest::dump_probes(ss);
+    auto output = ss.str();
+    EXPECT_TRUE(output.find("probe.sizes: count 100, mean 50.5, p50 51, p90 95, p99 100, max 100") !=
+                    std::string::npos,
+        output);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <Atliac/minitest.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// run the test with the arguments, returns the return value of run_test and the output
+inline auto run_test(std::vector<const char *> args)
+{
+    args.insert(args.begin(), "_");
+    std::ostringstream ss;
+    auto cout_buff = std::cout.rdbuf(ss.rdbuf());
+    auto rt = minitest::pri_impl::run_test(static_cast<int>(args.size()), args.data());
+    std::cout.rdbuf(cout_buff);
+    return std::pair{rt, ss.str()};
+}
+
+// run the test with the arguments, returns the return value of try_run_test and the output
+inline auto try_run_test(std::vector<const char *> args)
+{
+    args.insert(args.begin(), "_");
+    std::ostringstream ss;
+    auto cout_buff = std::cout.rdbuf(ss.rdbuf());
+    auto rt = minitest::pri_impl::try_run_test(static_cast<int>(args.size()), args.data());
+    std::cout.rdbuf(cout_buff);
+    return std::pair{rt, ss.str()};
+}
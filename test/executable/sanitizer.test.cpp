@@ -0,0 +1,30 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__GNUC__)
+// the hooks called by the sanitizer runtimes after a report, call them to simulate reports
+MINITEST_RECORD_SANITIZER_REPORTS();
+
+TEST_CASE("sanitizer.ubsan report", "manual") { __ubsan_on_report(); }
+
+TEST_CASE("sanitizer.tsan reports", "manual")
+{
+    __tsan_on_report(nullptr);
+    __tsan_on_report(nullptr);
+}
+
+TEST_CASE("sanitizer.clean", "manual") {}
+
+TEST_CASE("sanitizer: reports fail the test case")
+{
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "sanitizer.*"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("Error: 1 sanitizer report in the test case") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Error: 2 sanitizer reports in the test case") != std::string::npos, output);
+    EXPECT_TRUE(output.find("sanitizer.clean passed") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Failed: sanitizer.ubsan report") != std::string::npos, output);
+    EXPECT_TRUE(output.find("Failed: sanitizer.tsan reports") != std::string::npos, output);
+}
+#endif // defined(__linux__) && defined(__GNUC__)
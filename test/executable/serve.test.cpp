@@ -0,0 +1,160 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32) && __has_include(<sys/un.h>)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+// a client of the test server, the responses are read line by line
+class test_client
+{
+  public:
+    explicit test_client(const std::string &path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        // the server is started by a child process, wait until it listens
+        for (int i = 0; i < 500; ++i)
+        {
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (!connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address))) { return; }
+            close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    test_client(const test_client &) = delete;
+    test_client &operator=(const test_client &) = delete;
+    ~test_client()
+    {
+        if (fd >= 0) { close(fd); }
+    }
+
+    bool connected() const { return fd >= 0; }
+
+    // sends the request, returns the response up to and including its last line
+    std::vector<std::string> request(const std::string &line)
+    {
+        auto text = line + "\n";
+        (void)!write(fd, text.data(), text.size());
+        std::vector<std::string> response;
+        for (;;)
+        {
+            auto line_end = buffer.find('\n');
+            if (line_end == std::string::npos)
+            {
+                char chunk[1024];
+                auto received = read(fd, chunk, sizeof(chunk));
+                if (received <= 0) { return response; }
+                buffer.append(chunk, received);
+                continue;
+            }
+            response.push_back(buffer.substr(0, line_end));
+            buffer.erase(0, line_end + 1);
+            auto &last = response.back();
+            if (last.starts_with("done ") || last.starts_with("error ") || last == "bye") { return response; }
+        }
+    }
+
+  private:
+    int fd = -1;
+    std::string buffer;
+};
+
+bool contains(const std::vector<std::string> &lines, const std::string &line)
+{
+    return std::find(lines.begin(), lines.end(), line) != lines.end();
+}
+
+// the response of a run without the durations of the test cases
+std::vector<std::string> without_durations(std::vector<std::string> lines)
+{
+    for (auto &line : lines)
+    {
+        if (line.starts_with("passed ") || line.starts_with("failed ")) { line.erase(line.rfind(' ')); }
+    }
+    return lines;
+}
+
+int served_runs = 0;
+} // namespace
+
+TEST_CASE("serve.pass", "manual") { ++served_runs; }
+
+TEST_CASE("serve.fail", "manual")
+{
+    INFO("served runs: ", ++served_runs);
+    FAIL();
+}
+
+TEST_CASE("serve.crash", "manual") { std::abort(); }
+
+TEST_CASE("serve: list and run requests")
+{
+    auto socket_path = (std::filesystem::temp_directory_path() / "minitest_serve_test.sock").string();
+    auto serve_flag = minitest::pri_impl::flag_serve + ("=" + socket_path);
+    auto pid = fork();
+    ASSERT_TRUE(pid >= 0);
+    if (!pid)
+    {
+        const char *args[] = {"_", serve_flag.c_str()};
+        _exit(minitest::pri_impl::run_test(2, args));
+    }
+    {
+        test_client client(socket_path);
+        ASSERT_TRUE(client.connected());
+
+        auto response = client.request("list");
+        EXPECT_TRUE(contains(response, "test serve.pass"));
+        EXPECT_TRUE(contains(response, "test serve: list and run requests"));
+        EXPECT_TRUE(response.back() == "done " + std::to_string(response.size() - 1), response.back());
+
+        response = without_durations(client.request("run serve.pass"));
+        EXPECT_TRUE(response.front() == "case serve.pass", response.front());
+        EXPECT_TRUE(contains(response, "passed serve.pass"));
+        EXPECT_TRUE(response.back() == "done 1 1", response.back());
+
+        // each run is forked from the resident process, the runs before don't change it
+        response = without_durations(client.request("run serve.pass || serve.fail"));
+        EXPECT_TRUE(contains(response, "output served runs: 1"));
+        EXPECT_TRUE(contains(response, "failed serve.fail"));
+        EXPECT_TRUE(contains(response, "passed serve.pass"));
+        EXPECT_TRUE(response.back() == "done 1 2", response.back());
+
+        response = client.request("run serve.crash");
+        EXPECT_TRUE(response.back().starts_with("error the test run was terminated by the signal"), response.back());
+        EXPECT_TRUE(client.request("run (serve").back().starts_with("error minitest: invalid filter"));
+        EXPECT_TRUE(client.request("status").back() == "error unknown request: status");
+        EXPECT_TRUE(client.request("quit").back() == "bye");
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == MINITEST_SUCCESS);
+    EXPECT_FALSE(std::filesystem::exists(socket_path));
+    EXPECT_TRUE(served_runs == 0);
+}
+
+TEST_CASE("Failure Test: serve on a file which isn't a socket")
+{
+    auto file = std::filesystem::temp_directory_path() / "minitest_serve_not_a_socket.txt";
+    std::ofstream(file) << "kept";
+    auto serve_flag = minitest::pri_impl::flag_serve + ("=" + file.string());
+    auto [rt, output] = run_test({serve_flag.c_str()});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("exists and is not a socket") != std::string::npos, output);
+    EXPECT_TRUE(std::filesystem::exists(file));
+    std::filesystem::remove(file);
+}
+#endif // !defined(_WIN32) && __has_include(<sys/un.h>)
@@ -0,0 +1,80 @@
+#include "run_test.h"
+#include <Atliac/minitest.h>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// an absolute path, so the snapshots of the manual test cases are outside the source tree
+const auto snapshot_dir = std::filesystem::temp_directory_path() / "minitest_snapshot_test";
+const auto text_snapshot = (snapshot_dir / "text.txt").string();
+const auto binary_snapshot = (snapshot_dir / "binary.bin").string();
+std::string snapshot_text;
+std::array<std::uint32_t, 3> snapshot_binary{1, 2, 3};
+
+std::string numbered_lines(int first, int last)
+{
+    std::string lines;
+    for (int i = first; i <= last; ++i) { lines += "line " + std::to_string(i) + "\n"; }
+    return lines;
+}
+} // namespace
+
+TEST_CASE("snapshot: match the snapshot in the source tree")
+{
+    ASSERT_MATCHES_SNAPSHOT("greeting.txt", "Hello, minitest!\nSnapshots are compared byte by byte.\n");
+    std::string greeting = "Hello, minitest!\nSnapshots are compared byte by byte.\n";
+    ASSERT_MATCHES_SNAPSHOT("greeting.txt", greeting);
+    ASSERT_MATCHES_SNAPSHOT("greeting.txt", std::vector<char>(greeting.begin(), greeting.end()));
+}
+
+TEST_CASE("snapshot.text", "manual") { EXPECT_MATCHES_SNAPSHOT(text_snapshot.c_str(), snapshot_text); }
+
+TEST_CASE("snapshot.binary", "manual") { ASSERT_MATCHES_SNAPSHOT(binary_snapshot.c_str(), snapshot_binary); }
+
+TEST_CASE("snapshot: update and compare")
+{
+    std::filesystem::remove_all(snapshot_dir);
+    snapshot_text = numbered_lines(1, 20);
+
+    auto [rt, output] = run_test({minitest::pri_impl::flag_filter, "snapshot.*"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("text.txt doesn't exist, run with --minitest-update-snapshots") != std::string::npos,
+        output);
+
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_update_snapshots, minitest::pri_impl::flag_filter,
+        "snapshot.*"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("minitest: updated the snapshot " + text_snapshot) != std::string::npos, output);
+    EXPECT_TRUE(std::filesystem::file_size(binary_snapshot) == sizeof(snapshot_binary), output);
+
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_filter, "snapshot.*"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+
+    // only the changed lines and their context are shown
+    snapshot_text = numbered_lines(1, 9) + "line ten\n" + numbered_lines(11, 20);
+    snapshot_binary[1] = 5;
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_filter, "snapshot.*"});
+    EXPECT_TRUE(rt == MINITEST_FAILURE, output);
+    EXPECT_TRUE(output.find("--- " + text_snapshot + "\n+++ actual\n@@ -7,7 +7,7 @@\n line 7\n line 8\n line 9\n"
+                            "-line 10\n+line ten\n line 11\n line 12\n line 13\n") != std::string::npos,
+        output);
+    EXPECT_TRUE(output.find("line 14") == std::string::npos, output);
+    EXPECT_TRUE(output.find("at the byte 4, 12 bytes expected, 12 bytes actual.") != std::string::npos, output);
+
+    // the update is skipped if the snapshot matches
+    snapshot_binary[1] = 2;
+    std::tie(rt, output) = run_test({minitest::pri_impl::flag_update_snapshots, minitest::pri_impl::flag_filter,
+        "snapshot.*"});
+    EXPECT_TRUE(rt == MINITEST_SUCCESS, output);
+    EXPECT_TRUE(output.find("updated the snapshot " + binary_snapshot) == std::string::npos, output);
+    EXPECT_TRUE(output.find("updated the snapshot " + text_snapshot) != std::string::npos, output);
+    std::ifstream ifs(text_snapshot);
+    EXPECT_TRUE(std::string(std::istreambuf_iterator<char>(ifs), {}) == snapshot_text);
+    ifs.close();
+    std::filesystem::remove_all(snapshot_dir);
+}
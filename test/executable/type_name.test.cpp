@@ -0,0 +1,113 @@
+#include <Atliac/minitest.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+namespace
+{
+template <int> struct distinct_type
+{
+};
+
+// a stream buffer which discards the output
+struct null_buffer : std::streambuf
+{
+    null_buffer() { setp(buffer, std::end(buffer)); }
+    int overflow(int c) override
+    {
+        setp(buffer, std::end(buffer));
+        return c;
+    }
+    char buffer[256];
+};
+
+// the demangling without the cache, called on every failure before the cache was added
+std::string uncached_type_name(const std::type_info &type)
+{
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    auto demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string type_name = status ? type.name() : demangled;
+    std::free(demangled);
+    return type_name;
+#else
+    return type.name();
+#endif
+}
+} // namespace
+
+TEST_CASE("type name: demangled and cached")
+{
+#if __has_include(<cxxabi.h>)
+    EXPECT_TRUE(minitest::pri_impl::get_type_name(typeid(int)) == "int");
+    EXPECT_TRUE(minitest::pri_impl::get_type_name(std::runtime_error("")) == "std::runtime_error");
+    EXPECT_TRUE(minitest::pri_impl::get_type_name(typeid(distinct_type<1>)) == "(anonymous namespace)::distinct_type<1>");
+#endif
+    // the cached name is returned without copying
+    auto name = minitest::pri_impl::get_type_name(typeid(std::map<int, std::string>));
+    EXPECT_TRUE(minitest::pri_impl::get_type_name(typeid(std::map<int, std::string>)).data() == name.data());
+    EXPECT_TRUE(name == uncached_type_name(typeid(std::map<int, std::string>)));
+}
+
+TEST_CASE("type name: concurrent lookups")
+{
+    std::vector<std::string_view> names[4];
+    {
+        std::vector<std::jthread> threads;
+        for (auto &thread_names : names)
+        {
+            threads.emplace_back(
+                [&thread_names]
+                {
+                    for (int i = 0; i < 100; ++i)
+                    {
+                        thread_names.push_back(minitest::pri_impl::get_type_name(typeid(distinct_type<2>)));
+                        thread_names.push_back(minitest::pri_impl::get_type_name(typeid(distinct_type<3>)));
+                        thread_names.push_back(minitest::pri_impl::get_type_name(typeid(std::vector<short>)));
+                    }
+                });
+        }
+    }
+    for (auto &thread_names : names)
+    {
+        for (size_t i = 0; i < thread_names.size(); ++i) { EXPECT_TRUE(thread_names[i].data() == names[0][i % 3].data()); }
+    }
+}
+
+// the type name of an exception printed in a loop, with and without the cache, and the whole failure message
+TEST_CASE("type name: benchmark", "manual")
+{
+    constexpr int iterations = 1'000'000;
+    null_buffer discard;
+    auto cout_buff = std::cout.rdbuf(&discard);
+    auto per_iteration = [&](auto &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) { f(); }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    };
+    try
+    {
+        throw std::out_of_range("");
+    }
+    catch (const std::exception &e)
+    {
+        auto uncached = per_iteration([&] { std::cout << uncached_type_name(typeid(e)); });
+        auto cached = per_iteration([&] { std::cout << minitest::pri_impl::get_type_name(e); });
+        auto failure = per_iteration([&] { PRI_IMPL_MINITEST_THROWN("EXPECT_NO_THROW", f(), e); });
+        std::cout.rdbuf(cout_buff);
+        std::cout << std::format("type name uncached: {:.1f}ns, cached: {:.1f}ns ({:.1f}x), EXPECT_NO_THROW failure "
+                                 "message: {:.1f}ns",
+                         uncached, cached, uncached / cached, failure)
+                  << std::endl;
+    }
+}